@@ -31,6 +31,88 @@
 
 #include "Adafruit_TCS34725.h"
 
+/* Gain multiplier for each tcs34725Gain_t */
+static const uint8_t tcs34725GainFactor[4] = {1, 4, 16, 60};
+
+/* Accepted range of a measured gain ratio, Q10. Below 0.5 the single-cycle
+   rateScale() no longer fits 32 bits, and 128 keeps 12 x 256 cycles x ratio
+   well inside its divisor */
+static const uint32_t tcs34725MinGainRatio = 512;
+static const uint32_t tcs34725MaxGainRatio = 131072;
+
+/* Typical supply current in uA while integrating, waiting and asleep */
+static const float tcs34725ActiveCurrent = 235.0F;
+static const float tcs34725WaitCurrent = 65.0F;
+static const float tcs34725SleepCurrent = 2.5F;
+
+/* Oscillator warm-up after PON, and the margin poll() allows for a slow
+   internal oscillator, in us */
+static const uint16_t tcs34725WarmUp = 2400;
+static const uint16_t tcs34725PollMargin = 1000;
+
+/* Narrowest change detection window half-width, in clear channel counts, so
+   sensor noise in the dark does not keep re-triggering the interrupt */
+static const uint16_t tcs34725MinDeadband = 4;
+
+/* Mains detection: 125 cycles of 2.4ms (300ms) hold exactly 30 periods of
+   100Hz ripple and 36 of 120Hz, so both Goertzel bins are leakage free.
+   The coefficients are 2cos(2 pi k / N) for k = 30 and k = 36. */
+static const uint8_t tcs34725MainsSamples = 125;
+static const float tcs34725Goertzel100 = 0.125581039F;
+static const float tcs34725Goertzel120 = -0.472997994F;
+
+/*!
+ *  @brief  Orders sample queue slot accesses against the index updates. A
+ *          full memory barrier, since the producer and consumer may run on
+ *          different cores (ESP32); single-core AVR only needs the compiler
+ *          barrier.
+ */
+static inline void tcs34725Barrier() {
+#if defined(__AVR__)
+  __asm__ __volatile__("" ::: "memory");
+#else
+  __sync_synchronize();
+#endif
+}
+
+/*!
+ *  @brief  Subtracts with the result clamped at zero
+ *  @param  x
+ *          Value
+ *  @param  d
+ *          Amount to subtract
+ *  @return x - d, or 0 if d is larger
+ */
+static inline uint16_t tcs34725SubSat(uint16_t x, uint16_t d) {
+  return (x > d) ? x - d : 0;
+}
+
+/*!
+ *  @brief  Applies a colour correction matrix to one sample using only
+ *          32-bit integer math. Products are pre-shifted by 2 so the sum of
+ *          three cannot overflow.
+ *  @param  *ccm
+ *          Matrix
+ *  @param  *sample
+ *          Sample to correct in place
+ */
+static inline void tcs34725ApplyCcm(const tcs34725Ccm_t *ccm,
+                                    tcs34725Sample_t *sample) {
+  int32_t in[3] = {sample->r, sample->g, sample->b};
+  uint16_t *out[3] = {&sample->r, &sample->g, &sample->b};
+  uint8_t shift = 13 - ccm->shift;
+
+  for (uint8_t i = 0; i < 3; i++) {
+    int32_t acc = ((ccm->m[i][0] * in[0]) >> 2) +
+                  ((ccm->m[i][1] * in[1]) >> 2) +
+                  ((ccm->m[i][2] * in[2]) >> 2);
+    acc = (acc + (1L << (shift - 1))) >> shift;
+    acc += ccm->offset[i];
+    *out[i] = (acc < 0) ? 0 : (acc > 65535) ? 65535 : (uint16_t)acc;
+  }
+}
+
+#if defined(ARDUINO)
 /*!
  *  @brief  Implements missing powf function
  *  @param  x
@@ -43,6 +125,132 @@ float powf(const float x, const float y) {
   return (float)(pow((double)x, (double)y));
 }
 
+/*!
+ *  @brief  Constructor
+ *  @param  addr
+ *          i2c address
+ *  @param  *theWire
+ *          The Wire object
+ */
+Adafruit_TCS34725_BusIO::Adafruit_TCS34725_BusIO(uint8_t addr,
+                                                 TwoWire *theWire)
+    : _dev(addr, theWire) {}
+
+/*!
+ *  @brief  Initializes the I2C device
+ *  @return True if the device acknowledged its address
+ */
+bool Adafruit_TCS34725_BusIO::begin() { return _dev.begin(); }
+
+/*!
+ *  @brief  Writes a buffer over I2C
+ *  @param  *buffer
+ *          Bytes to write
+ *  @param  len
+ *          Number of bytes
+ *  @return True on success
+ */
+bool Adafruit_TCS34725_BusIO::write(const uint8_t *buffer, size_t len) {
+  return _dev.write(buffer, len);
+}
+
+/*!
+ *  @brief  Writes then reads over I2C with a repeated start
+ *  @param  *write_buffer
+ *          Bytes to write
+ *  @param  write_len
+ *          Number of bytes to write
+ *  @param  *read_buffer
+ *          Destination for the bytes read
+ *  @param  read_len
+ *          Number of bytes to read
+ *  @return True on success
+ */
+bool Adafruit_TCS34725_BusIO::write_then_read(const uint8_t *write_buffer,
+                                              size_t write_len,
+                                              uint8_t *read_buffer,
+                                              size_t read_len) {
+  return _dev.write_then_read(write_buffer, write_len, read_buffer, read_len);
+}
+#endif
+
+/*!
+ *  @brief  Gets the transport all register access goes through
+ *  @return The transport given to begin(), the built-in BusIO one, or NULL
+ *          if there is none
+ */
+inline Adafruit_TCS34725_Transport *Adafruit_TCS34725::transport() {
+#if defined(ARDUINO)
+  /* NULL rather than &_busio, so copies of this object stay valid */
+  return _bus ? _bus : &_busio;
+#else
+  return _bus;
+#endif
+}
+
+/*!
+ *  @brief  Issues a write transaction, updating the instrumentation if
+ *          TCS34725_STATS is defined
+ *  @param  op
+ *          Operation being performed (tcs34725Op_t)
+ *  @param  *buffer
+ *          Bytes to write
+ *  @param  len
+ *          Number of bytes
+ *  @return True on success
+ */
+inline bool Adafruit_TCS34725::busWrite(uint8_t op, const uint8_t *buffer,
+                                        size_t len) {
+  return busWriteRead(op, buffer, len, NULL, 0);
+}
+
+/*!
+ *  @brief  Issues a write, or a combined write/read if rlen is non-zero,
+ *          updating the instrumentation if TCS34725_STATS is defined
+ *  @param  op
+ *          Operation being performed (tcs34725Op_t)
+ *  @param  *wbuf
+ *          Bytes to write
+ *  @param  wlen
+ *          Number of bytes to write
+ *  @param  *rbuf
+ *          Destination for the bytes read
+ *  @param  rlen
+ *          Number of bytes to read
+ *  @return True on success
+ */
+inline bool Adafruit_TCS34725::busWriteRead(uint8_t op, const uint8_t *wbuf,
+                                            size_t wlen, uint8_t *rbuf,
+                                            size_t rlen) {
+#ifdef TCS34725_STATS
+  uint32_t start = micros();
+#else
+  (void)op;
+#endif
+
+  Adafruit_TCS34725_Transport *bus = transport();
+  if (!bus)
+    return false;
+  bool ok = rlen ? bus->write_then_read(wbuf, wlen, rbuf, rlen)
+                 : bus->write(wbuf, wlen);
+  _transactions++;
+
+#ifdef TCS34725_STATS
+  uint32_t elapsed = (micros() - start) >> 6;
+  uint8_t bucket = 0;
+  while (elapsed && bucket < TCS34725_STATS_BUCKETS - 1) {
+    elapsed >>= 1;
+    bucket++;
+  }
+  if (_stats.latency[op][bucket] < 0xFFFF)
+    _stats.latency[op][bucket]++;
+  _stats.bytes += wlen + rlen;
+  if (!ok)
+    _stats.nacks++;
+#endif
+  return ok;
+}
+
 /*!
  *  @brief  Writes a register and an 8 bit value over I2C
  *  @param  reg
@@ -50,7 +258,70 @@ float powf(const float x, const float y) {
  */
 void Adafruit_TCS34725::write8(uint8_t reg, uint8_t value) {
   uint8_t buffer[2] = {(uint8_t)(TCS34725_COMMAND_BIT | reg), value};
-  i2c_dev->write(buffer, 2);
+  busWrite(TCS34725_OP_WRITE8, buffer, 2);
+
+  if (reg == TCS34725_ENABLE) {
+    /* Setting AEN starts a cycle, once the oscillator has warmed up */
+    uint8_t rising = value & ~_shadow[TCS34725_ENABLE];
+    uint32_t now = micros();
+    if (rising & TCS34725_ENABLE_PON)
+      _ponTime = now;
+    if (rising & TCS34725_ENABLE_AEN) {
+      uint32_t on = now - _ponTime;
+      _cycleEnd = now + (256 - _shadow[TCS34725_ATIME]) * 2400UL;
+      if (on < tcs34725WarmUp)
+        _cycleEnd += tcs34725WarmUp - on;
+    }
+  }
+
+  /* Keep the shadow copy coherent with writes made through the public API */
+  if (reg <= TCS34725_CONTROL)
+    _shadow[reg] = value;
+}
+
+/*!
+ *  @brief  Writes a configuration register only if its value differs from
+ *          the shadow copy
+ *  @param  reg
+ *          Register (0x00-0x0F)
+ *  @param  value
+ *          New value
+ */
+void Adafruit_TCS34725::updateRegister(uint8_t reg, uint8_t value) {
+  if (_shadow[reg] != value)
+    write8(reg, value);
+}
+
+/*!
+ *  @brief  Writes a run of adjacent configuration registers, skipping the
+ *          ones that already hold the requested value. The changed bytes are
+ *          sent as a single auto-increment write.
+ *  @param  reg
+ *          First register (0x00-0x0F)
+ *  @param  *values
+ *          New values, one per register
+ *  @param  len
+ *          Number of registers; reg + len must not pass TCS34725_CONTROL
+ */
+void Adafruit_TCS34725::updateRegisters(uint8_t reg, const uint8_t *values,
+                                        uint8_t len) {
+  uint8_t first = len, last = 0;
+  for (uint8_t i = 0; i < len; i++) {
+    if (_shadow[reg + i] != values[i]) {
+      if (first == len)
+        first = i;
+      last = i;
+    }
+  }
+  if (first == len)
+    return; /* Nothing changed */
+
+  uint8_t buffer[TCS34725_CONTROL + 2];
+  uint8_t n = last - first + 1;
+  buffer[0] = TCS34725_COMMAND_BIT | TCS34725_COMMAND_AUTOINC | (reg + first);
+  memcpy(buffer + 1, values + first, n);
+  busWrite(TCS34725_OP_WRITE_BLOCK, buffer, n + 1);
+  memcpy(_shadow + reg + first, values + first, n);
 }
 
 /*!
@@ -60,7 +331,7 @@ void Adafruit_TCS34725::write8(uint8_t reg, uint8_t value) {
  */
 uint8_t Adafruit_TCS34725::read8(uint8_t reg) {
   uint8_t buffer[1] = {(uint8_t)(TCS34725_COMMAND_BIT | reg)};
-  i2c_dev->write_then_read(buffer, 1, buffer, 1);
+  busWriteRead(TCS34725_OP_READ8, buffer, 1, buffer, 1);
   return buffer[0];
 }
 
@@ -71,25 +342,485 @@ uint8_t Adafruit_TCS34725::read8(uint8_t reg) {
  */
 uint16_t Adafruit_TCS34725::read16(uint8_t reg) {
   uint8_t buffer[2] = {(uint8_t)(TCS34725_COMMAND_BIT | reg), 0};
-  i2c_dev->write_then_read(buffer, 1, buffer, 2);
+  busWriteRead(TCS34725_OP_READ16, buffer, 1, buffer, 2);
   return (uint16_t(buffer[1]) << 8) | (uint16_t(buffer[0]) & 0xFF);
 }
 
+/*!
+ *  @brief  Reads a block of consecutive registers in a single I2C
+ *          transaction using the auto-increment command type
+ *  @param  reg
+ *          First register to read
+ *  @param  *buffer
+ *          Destination for the register contents
+ *  @param  len
+ *          Number of registers to read
+ */
+void Adafruit_TCS34725::readBlock(uint8_t reg, uint8_t *buffer, uint8_t len) {
+  uint8_t cmd[1] = {
+      (uint8_t)(TCS34725_COMMAND_BIT | TCS34725_COMMAND_AUTOINC | reg)};
+  busWriteRead(TCS34725_OP_READ_BLOCK, cmd, 1, buffer, len);
+}
+
+/*!
+ *  @brief  Gets the number of I2C transactions issued since the last call to
+ *          resetTransactionCount() or resetStats()
+ *  @return Transaction count
+ */
+uint32_t Adafruit_TCS34725::getTransactionCount() { return _transactions; }
+
+/*!
+ *  @brief  Resets the I2C transaction counter to zero
+ */
+void Adafruit_TCS34725::resetTransactionCount() { _transactions = 0; }
+
+#ifdef TCS34725_STATS
+/*!
+ *  @brief  Gets a snapshot of the I2C instrumentation counters
+ *  @param  *stats
+ *          Snapshot to fill
+ */
+void Adafruit_TCS34725::getStats(tcs34725Stats_t *stats) {
+  *stats = _stats;
+  stats->transactions = _transactions;
+}
+
+/*!
+ *  @brief  Resets all instrumentation counters, including the transaction
+ *          count, to zero
+ */
+void Adafruit_TCS34725::resetStats() {
+  memset(&_stats, 0, sizeof(_stats));
+  _transactions = 0;
+}
+#endif
+
+/*!
+ *  @brief  Gets the time needed to complete one integration cycle at the
+ *          current integration time
+ *  @return Integration time in milliseconds, rounded up
+ */
+uint16_t Adafruit_TCS34725::integrationDelay() { return _integrationDelay; }
+
+/*!
+ *  @brief  Recomputes the quantities that depend only on the integration
+ *          time and gain, so the per-sample paths do not have to. Called
+ *          whenever either changes.
+ */
+void Adafruit_TCS34725::updateDerived() {
+  uint16_t cycles = 256 - _tcs34725IntegrationTime;
+  /* Measured gain if calibrated, otherwise nominal; Q10 */
+  uint32_t gain = _gainRatio[_tcs34725Gain];
+
+  /* 12/5 = 2.4, add 1 to account for integer truncation */
+  _integrationDelay = cycles * 12 / 5 + 1;
+
+  /* Analog/Digital saturation:
+   *
+   * (a) As light becomes brighter, the clear channel will tend to
+   *     saturate first since R+G+B is approximately equal to C.
+   * (b) The TCS34725 accumulates 1024 counts per 2.4ms of integration
+   *     time, up to a maximum values of 65535. This means analog
+   *     saturation can occur up to an integration time of 153.6ms
+   *     (64*2.4ms=153.6ms).
+   * (c) If the integration time is > 153.6ms, digital saturation will
+   *     occur before analog saturation. Digital saturation occurs when
+   *     the count reaches 65535.
+   */
+  if (cycles > 63) {
+    /* Track digital saturation */
+    _saturation = 65535;
+    _saturation75 = 65535;
+  } else {
+    /* Track analog saturation */
+    _saturation = 1024 * cycles;
+    /* Adjust sat to 75% to avoid analog saturation if atime < 153.6ms */
+    _saturation75 = _saturation - _saturation / 4;
+  }
+
+  /* The integer lux path uses 384 * cycles * gain, see dn40Lux(). With the
+     Q10 gain: 384 / 1024 = 3 / 8 */
+  _luxDivisor = (3UL * cycles * gain + 4) >> 3;
+  /* Worked out by normalizeSample() when first needed, so builds that do
+     not use it do not pull in the 64-bit division */
+  _rateScale = 0;
+  /* Likewise for float code */
+  _countsPerLux = 0;
+  _maxLux = 0;
+  _dark = findDark(_tcs34725IntegrationTime, _tcs34725Gain);
+
+  /* Only a change of setting starts a new generation, so re-applying a
+     configuration or a gain ratio update does not use one up */
+  if (_tcs34725IntegrationTime != _generationAtime ||
+      _tcs34725Gain != _generationGain) {
+    _generationAtime = _tcs34725IntegrationTime;
+    _generationGain = _tcs34725Gain;
+    _generation++;
+  }
+}
+
+/*!
+ *  @brief  Gets the factor that turns counts into a count rate for a given
+ *          configuration: 2^32 / (2.4ms x cycles x gain), so that
+ *          (counts x factor) >> 16 is counts/ms/gain in Q16.16. The gain is
+ *          the measured one if calibrateGains() has been run.
+ *  @param  atime
+ *          Integration time (TCS34725_INTEGRATIONTIME_*)
+ *  @param  gain
+ *          Gain (tcs34725Gain_t)
+ *  @return Scale factor
+ */
+uint32_t Adafruit_TCS34725::rateScale(uint8_t atime, uint8_t gain) {
+  /* 2.4 = 12/5, and the gain is Q10 */
+  uint32_t divisor = 12UL * (256 - atime) * _gainRatio[gain & 0x03];
+  return (uint32_t)((5ULL << 42) / divisor);
+}
+
+/*!
+ *  @brief  Measures the actual ratios between the gain settings against a
+ *          steady light source. Each pair of adjacent gains is measured at
+ *          the same integration time, chosen so the higher gain reads about
+ *          24000 counts, and the ratios are chained from 1x. The results
+ *          replace the nominal 1/4/16/60 in the lux and count-rate outputs,
+ *          so range changes do not cause steps. The configuration is
+ *          restored afterwards. Can take up to 15 seconds in dim light.
+ *  @param  samples
+ *          Readings averaged at each setting
+ *  @return True if all three ratios were measured. Pairs that could not be
+ *          measured (source too bright or too dark, or a ratio more than
+ *          25% from nominal or above 128.0) keep their previous value.
+ */
+boolean Adafruit_TCS34725::calibrateGains(uint8_t samples) {
+  if (!_tcs34725Initialised)
+    init();
+  if (samples == 0)
+    samples = 1;
+
+  tcs34725Config_t saved;
+  getConfig(&saved);
+
+  uint32_t ratio[4];
+  memcpy(ratio, _gainRatio, sizeof(ratio));
+  boolean complete = true;
+
+  for (uint8_t lo = TCS34725_GAIN_1X; lo < TCS34725_GAIN_60X; lo++) {
+    uint8_t hi = lo + 1;
+
+    /* One cycle at the higher gain gives the rate to aim from; 768 counts
+       is the 75% ripple saturation level for a single cycle */
+    uint32_t probe = measureClear(TCS34725_INTEGRATIONTIME_2_4MS,
+                                  (tcs34725Gain_t)hi, 1);
+    if (probe >= 768) {
+      complete = false;
+      continue;
+    }
+    uint32_t cycles = probe ? 24000 / probe : 256;
+    if (cycles > 256)
+      cycles = 256;
+
+    uint32_t cHi = measureClear(256 - cycles, (tcs34725Gain_t)hi, samples);
+    uint32_t cLo = measureClear(256 - cycles, (tcs34725Gain_t)lo, samples);
+    if (cLo < 100UL * samples || cHi >= (uint32_t)_saturation75 * samples) {
+      complete = false;
+      continue;
+    }
+
+    uint32_t measured = (uint64_t)ratio[lo] * cHi / cLo;
+    uint32_t nominal = (uint32_t)ratio[lo] * tcs34725GainFactor[hi] /
+                       tcs34725GainFactor[lo];
+    if (measured < nominal - nominal / 4 || measured > nominal + nominal / 4 ||
+        measured > tcs34725MaxGainRatio) {
+      complete = false;
+      continue;
+    }
+    ratio[hi] = measured;
+  }
+
+  memcpy(_gainRatio, ratio, sizeof(ratio));
+
+  /* Dropping AEN first makes applyConfig() restart the cycle; it also
+     recomputes the derived values with the new ratios */
+  write8(TCS34725_ENABLE, TCS34725_ENABLE_PON);
+  applyConfig(&saved);
+  return complete;
+}
+
+/*!
+ *  @brief  Sets the gain ratios, e.g. ones saved from an earlier
+ *          calibrateGains() run
+ *  @param  ratios
+ *          Gain multiplier for 1x, 4x, 16x and 60x in Q10 (1024 = 1.0),
+ *          each from 512 (0.5) to 131072 (128.0)
+ *  @return True if the ratios were accepted. Otherwise, e.g. for a zero from
+ *          blank storage, the ratios in use are kept.
+ */
+boolean Adafruit_TCS34725::setGainRatios(const uint32_t ratios[4]) {
+  for (uint8_t i = 0; i < 4; i++) {
+    if (ratios[i] < tcs34725MinGainRatio || ratios[i] > tcs34725MaxGainRatio)
+      return false;
+  }
+
+  memcpy(_gainRatio, ratios, sizeof(_gainRatio));
+  updateDerived();
+  return true;
+}
+
+/*!
+ *  @brief  Gets the gain ratios in use
+ *  @param  ratios
+ *          Destination for the multipliers for 1x, 4x, 16x and 60x in Q10
+ *          (1024 = 1.0)
+ */
+void Adafruit_TCS34725::getGainRatios(uint32_t ratios[4]) {
+  memcpy(ratios, _gainRatio, sizeof(_gainRatio));
+}
+
+/*!
+ *  @brief  Takes fresh readings at a given setting for calibrateGains()
+ *  @param  atime
+ *          Integration time
+ *  @param  gain
+ *          Gain
+ *  @param  samples
+ *          Number of readings
+ *  @return Sum of the clear channel readings
+ */
+uint32_t Adafruit_TCS34725::measureClear(uint8_t atime, tcs34725Gain_t gain,
+                                         uint8_t samples) {
+  setIntegrationTime(atime);
+  setGain(gain);
+
+  uint32_t sum[4];
+  measureSum(samples, sum);
+  return sum[0];
+}
+
+/*!
+ *  @brief  Takes fresh readings at the current setting, each from its own
+ *          complete integration
+ *  @param  samples
+ *          Number of readings
+ *  @param  sum
+ *          Destination for the per-channel sums, C/R/G/B order
+ */
+void Adafruit_TCS34725::measureSum(uint8_t samples, uint32_t sum[4]) {
+  sum[0] = sum[1] = sum[2] = sum[3] = 0;
+  for (uint8_t i = 0; i < samples; i++) {
+    startMeasurement();
+    wait(integrationDelay() + 3);
+
+    /* Allow for a slow internal oscillator, as getRawDataOneShot() does */
+    tcs34725Snapshot_t snap;
+    for (uint8_t tries = 0; !getSnapshot(&snap) && tries < 10; tries++)
+      wait(1);
+    sum[0] += snap.c;
+    sum[1] += snap.r;
+    sum[2] += snap.g;
+    sum[3] += snap.b;
+  }
+  _measuring = false;
+}
+
+/*!
+ *  @brief  Provides storage for dark offsets, one entry per integration time
+ *          and gain combination captured with captureDark(). By default
+ *          every entry is marked free, so a zero-initialised array works.
+ *          To use entries pre-filled, e.g. from EEPROM, pass clear = false
+ *          and set gain to 0xFF in the unused ones.
+ *  @param  *table
+ *          Table storage; must outlive this object. NULL disables dark
+ *          subtraction.
+ *  @param  size
+ *          Number of entries
+ *  @param  clear
+ *          True to mark every entry free, false to keep the contents
+ */
+void Adafruit_TCS34725::setDarkTable(tcs34725Dark_t *table, uint8_t size,
+                                     boolean clear) {
+  _darkTable = table;
+  _darkSize = table ? size : 0;
+  if (clear) {
+    for (uint8_t i = 0; i < _darkSize; i++)
+      _darkTable[i].gain = 0xFF;
+  }
+  _dark = findDark(_tcs34725IntegrationTime, _tcs34725Gain);
+}
+
+/*!
+ *  @brief  Measures the dark count of every channel at the current
+ *          integration time and gain and stores it in the dark table,
+ *          replacing any earlier entry for the same setting. The sensor must
+ *          see no light: LED off and aperture covered. Repeat for each
+ *          setting in use.
+ *  @param  samples
+ *          Readings to average
+ *  @return True if stored; false if no table was set or it is full
+ */
+boolean Adafruit_TCS34725::captureDark(uint8_t samples) {
+  if (!_tcs34725Initialised)
+    init();
+  if (samples == 0)
+    samples = 1;
+
+  tcs34725Dark_t *entry = findDark(_tcs34725IntegrationTime, _tcs34725Gain);
+  if (!entry)
+    entry = findDark(0, 0xFF);
+  if (!entry)
+    return false;
+
+  uint32_t sum[4];
+  measureSum(samples, sum);
+
+  entry->atime = _tcs34725IntegrationTime;
+  entry->gain = _tcs34725Gain;
+  entry->c = (sum[0] + samples / 2) / samples;
+  entry->r = (sum[1] + samples / 2) / samples;
+  entry->g = (sum[2] + samples / 2) / samples;
+  entry->b = (sum[3] + samples / 2) / samples;
+  _dark = entry;
+  return true;
+}
+
+/*!
+ *  @brief  Removes the dark offset for the current integration time and gain
+ *          from raw values, clamping at zero. Does nothing if no offset has
+ *          been captured for this setting. getSample() does this itself.
+ *  @param  *r
+ *          Red value
+ *  @param  *g
+ *          Green value
+ *  @param  *b
+ *          Blue value
+ *  @param  *c
+ *          Clear channel value
+ */
+void Adafruit_TCS34725::subtractDark(uint16_t *r, uint16_t *g, uint16_t *b,
+                                     uint16_t *c) {
+  if (!_dark)
+    return;
+  *r = tcs34725SubSat(*r, _dark->r);
+  *g = tcs34725SubSat(*g, _dark->g);
+  *b = tcs34725SubSat(*b, _dark->b);
+  *c = tcs34725SubSat(*c, _dark->c);
+}
+
+/*!
+ *  @brief  Sets the colour correction matrix used by correctColor(), e.g. a
+ *          per-product calibration
+ *  @param  *ccm
+ *          Matrix; must outlive this object. NULL turns correction off.
+ *  @return False if the matrix shift is outside 0-3, in which case
+ *          correction is turned off
+ */
+boolean Adafruit_TCS34725::setColorCorrection(const tcs34725Ccm_t *ccm) {
+  if (ccm && ccm->shift > 3) {
+    _ccm = NULL;
+    return false;
+  }
+  _ccm = ccm;
+  return true;
+}
+
+/*!
+ *  @brief  Applies the colour correction matrix to the R, G and B values of
+ *          a sample in one integer pass, clamping the results to 0-65535.
+ *          The clear channel is left as it is.
+ *  @param  *sample
+ *          Sample to correct in place
+ */
+void Adafruit_TCS34725::correctColor(tcs34725Sample_t *sample) {
+  if (_ccm)
+    tcs34725ApplyCcm(_ccm, sample);
+}
+
+/*!
+ *  @brief  Applies the colour correction matrix to an array of samples, e.g.
+ *          a batch drained from the interrupt queue
+ *  @param  *samples
+ *          Samples to correct in place
+ *  @param  count
+ *          Number of samples
+ */
+void Adafruit_TCS34725::correctColor(tcs34725Sample_t *samples,
+                                     uint16_t count) {
+  if (!_ccm)
+    return;
+  for (uint16_t i = 0; i < count; i++)
+    tcs34725ApplyCcm(_ccm, &samples[i]);
+}
+
+/*!
+ *  @brief  Finds the dark table entry for a setting
+ *  @param  atime
+ *          Integration time; ignored when looking for a free entry
+ *  @param  gain
+ *          Gain, or 0xFF to find a free entry
+ *  @return The entry, or NULL if there is none
+ */
+tcs34725Dark_t *Adafruit_TCS34725::findDark(uint8_t atime, uint8_t gain) {
+  for (uint8_t i = 0; i < _darkSize; i++) {
+    if (_darkTable[i].gain == gain &&
+        (gain == 0xFF || _darkTable[i].atime == atime))
+      return &_darkTable[i];
+  }
+  return NULL;
+}
+
+/*!
+ *  @brief  Gets the clear count at which the ADC saturates at the current
+ *          integration time
+ *  @return Saturation level
+ */
+uint16_t Adafruit_TCS34725::getSaturation() { return _saturation; }
+
+/*!
+ *  @brief  Gets the saturation level allowing for ripple: 75% of
+ *          getSaturation() for integration times up to 153.6ms
+ *  @return Ripple-adjusted saturation level
+ */
+uint16_t Adafruit_TCS34725::getSaturation75() { return _saturation75; }
+
+/*!
+ *  @brief  Gets the DN40 counts per lux at the current integration time and
+ *          gain
+ *  @return Counts per lux
+ */
+float Adafruit_TCS34725::getCountsPerLux() {
+  /* DN40: counts per lux = ATIME_ms * AGAINx / (GA * DF), GA = 1, DF = 310.
+     Worked out on first use after a change rather than in updateDerived(),
+     so float code is only linked in by sketches that call it. */
+  if (_countsPerLux == 0)
+    _countsPerLux = 2.4F * (256 - _tcs34725IntegrationTime) *
+                    _gainRatio[_tcs34725Gain] / (310.0F * 1024);
+  return _countsPerLux;
+}
+
+/*!
+ *  @brief  Gets the largest lux value measurable at the current integration
+ *          time and gain, following DN40
+ *  @return Maximum lux
+ */
+float Adafruit_TCS34725::getMaxLux() {
+  if (_maxLux == 0)
+    _maxLux = 65535.0F / (getCountsPerLux() * 3);
+  return _maxLux;
+}
+
 /*!
  *  @brief  Enables the device
  */
 void Adafruit_TCS34725::enable() {
-  write8(TCS34725_ENABLE, TCS34725_ENABLE_PON);
-  delay(3);
-  write8(TCS34725_ENABLE, TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN);
+  uint8_t reg = _shadow[TCS34725_ENABLE] & ~TCS34725_ENABLE_AEN;
+  write8(TCS34725_ENABLE, reg | TCS34725_ENABLE_PON);
+  wait(3);
+  write8(TCS34725_ENABLE, reg | TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN);
   /* Set a delay for the integration time.
     This is only necessary in the case where enabling and then
     immediately trying to read values back. This is because setting
     AEN triggers an automatic integration, so if a read RGBC is
     performed too quickly, the data is not yet valid and all 0's are
     returned */
-  /* 12/5 = 2.4, add 1 to account for integer truncation */
-  delay((256 - _tcs34725IntegrationTime) * 12 / 5 + 1);
+  wait(integrationDelay());
 }
 
 /*!
@@ -97,9 +828,9 @@ void Adafruit_TCS34725::enable() {
  */
 void Adafruit_TCS34725::disable() {
   /* Turn the device off to save power */
-  uint8_t reg = 0;
-  reg = read8(TCS34725_ENABLE);
-  write8(TCS34725_ENABLE, reg & ~(TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN));
+  uint8_t reg = _shadow[TCS34725_ENABLE];
+  updateRegister(TCS34725_ENABLE,
+                 reg & ~(TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN));
 }
 
 /*!
@@ -108,13 +839,25 @@ void Adafruit_TCS34725::disable() {
  *          Integration Time
  *  @param  gain
  *          Gain
+ *  @param  build
+ *          Leave as the default. Its type differs with TCS34725_STATS, so a
+ *          sketch built with a different setting from the library fails to
+ *          link instead of disagreeing on the object layout.
  */
-Adafruit_TCS34725::Adafruit_TCS34725(uint8_t it, tcs34725Gain_t gain) {
+Adafruit_TCS34725::Adafruit_TCS34725(uint8_t it, tcs34725Gain_t gain,
+                                     tcs34725Build_t build)
+#if defined(ARDUINO)
+    : _busio(TCS34725_ADDRESS, &Wire)
+#endif
+{
   _tcs34725Initialised = false;
   _tcs34725IntegrationTime = it;
   _tcs34725Gain = gain;
+  (void)build;
+  updateDerived();
 }
 
+#if defined(ARDUINO)
 /*!
  *  @brief  Initializes I2C and configures the sensor
  *  @param  addr
@@ -124,9 +867,22 @@ Adafruit_TCS34725::Adafruit_TCS34725(uint8_t it, tcs34725Gain_t gain) {
  *  @return True if initialization was successful, otherwise false.
  */
 boolean Adafruit_TCS34725::begin(uint8_t addr, TwoWire *theWire) {
-  if (i2c_dev)
-    delete i2c_dev;
-  i2c_dev = new Adafruit_I2CDevice(addr, theWire);
+  _busio = Adafruit_TCS34725_BusIO(addr, theWire);
+  _bus = NULL;
+
+  return init();
+}
+#endif
+
+/*!
+ *  @brief  Initializes the sensor over a caller-supplied transport, e.g. a
+ *          different bus or a simulated device
+ *  @param  *transport
+ *          Transport to use; must outlive this object
+ *  @return True if initialization was successful, otherwise false.
+ */
+boolean Adafruit_TCS34725::begin(Adafruit_TCS34725_Transport *transport) {
+  _bus = transport;
 
   return init();
 }
@@ -136,7 +892,8 @@ boolean Adafruit_TCS34725::begin(uint8_t addr, TwoWire *theWire) {
  *  @return True if initialization was successful, otherwise false.
  */
 boolean Adafruit_TCS34725::init() {
-  if (!i2c_dev->begin())
+  Adafruit_TCS34725_Transport *bus = transport();
+  if (!bus || !bus->begin())
     return false;
 
   /* Make sure we're actually connected */
@@ -144,97 +901,779 @@ boolean Adafruit_TCS34725::init() {
   if ((x != 0x4d) && (x != 0x44) && (x != 0x10)) {
     return false;
   }
-  _tcs34725Initialised = true;
+  _tcs34725Initialised = true;
+
+  /* Seed the shadow copy from the device, which may have kept its settings
+     across an MCU reset */
+  readBlock(TCS34725_ENABLE, _shadow, sizeof(_shadow));
+
+  /* Set default integration time and gain */
+  updateRegister(TCS34725_ATIME, _tcs34725IntegrationTime);
+  updateRegister(TCS34725_CONTROL, _tcs34725Gain);
+
+  /* Start from a known ENABLE value, PON | AEN, as a fresh power-up would:
+     interrupt or wait mode left on by an earlier run must not survive */
+  _shadow[TCS34725_ENABLE] = 0;
+
+  /* Note: by default, the device is in power down mode on bootup */
+  enable();
+
+  return true;
+}
+
+/*!
+ *  @brief  Sets the integration time for the TC34725. If the ADC is running
+ *          the cycle in progress is abandoned, as in applyConfig(), so the
+ *          next result is integrated entirely at the new setting.
+ *  @param  it
+ *          Integration Time
+ */
+void Adafruit_TCS34725::setIntegrationTime(uint8_t it) {
+  if (!_tcs34725Initialised)
+    init();
+  if (it == _shadow[TCS34725_ATIME] && it == _tcs34725IntegrationTime)
+    return;
+
+  /* Update the timing register */
+  updateRegister(TCS34725_ATIME, it);
+  restartCycle();
+
+  /* Update value placeholders */
+  _tcs34725IntegrationTime = it;
+  updateDerived();
+}
+
+/*!
+ *  @brief  Adjusts the gain on the TCS34725. If the ADC is running the
+ *          cycle in progress is abandoned, as in applyConfig(), so the next
+ *          result is integrated entirely at the new gain.
+ *  @param  gain
+ *          Gain (sensitivity to light)
+ */
+void Adafruit_TCS34725::setGain(tcs34725Gain_t gain) {
+  if (!_tcs34725Initialised)
+    init();
+  if (gain == _shadow[TCS34725_CONTROL] && gain == _tcs34725Gain)
+    return;
+
+  /* Update the timing register */
+  updateRegister(TCS34725_CONTROL, gain);
+  restartCycle();
+
+  /* Update value placeholders */
+  _tcs34725Gain = gain;
+  updateDerived();
+}
+
+/*!
+ *  @brief  Drops and sets AEN, if it is set, so the RGBC cycle starts again
+ *          with the current ATIME and gain and AVALID is cleared until it
+ *          completes. A pending poll() deadline moves with it.
+ */
+void Adafruit_TCS34725::restartCycle() {
+  uint8_t reg = _shadow[TCS34725_ENABLE];
+  if (!(reg & TCS34725_ENABLE_AEN))
+    return;
+
+  write8(TCS34725_ENABLE, reg & ~TCS34725_ENABLE_AEN);
+  write8(TCS34725_ENABLE, reg);
+  if (_measuring)
+    _sampleDeadline = _cycleEnd + tcs34725PollMargin;
+}
+
+/*!
+ *  @brief  Gets the integration time currently in use
+ *  @return Integration time (TCS34725_INTEGRATIONTIME_*)
+ */
+uint8_t Adafruit_TCS34725::getIntegrationTime() {
+  return _tcs34725IntegrationTime;
+}
+
+/*!
+ *  @brief  Gets the gain currently in use
+ *  @return Gain
+ */
+tcs34725Gain_t Adafruit_TCS34725::getGain() { return _tcs34725Gain; }
+
+/*!
+ *  @brief  Applies a complete configuration. Only registers that differ from
+ *          the current state are written, with adjacent registers coalesced,
+ *          so this costs at most six I2C transactions and none if nothing
+ *          changed. If the ADC is running and the integration time, gain or
+ *          wait time changes, AEN is dropped first and set again last, so
+ *          the cycle in progress is abandoned and the next result is the
+ *          first one taken entirely with the new settings.
+ *  @param  *config
+ *          Configuration to apply
+ */
+void Adafruit_TCS34725::applyConfig(const tcs34725Config_t *config) {
+  if (!_tcs34725Initialised)
+    init();
+
+  uint8_t wlong = config->wlong ? TCS34725_CONFIG_WLONG : 0;
+  uint8_t enable = _shadow[TCS34725_ENABLE];
+  boolean timing =
+      config->atime != _shadow[TCS34725_ATIME] ||
+      config->gain != _shadow[TCS34725_CONTROL] ||
+      config->wtime != _shadow[TCS34725_WTIME] ||
+      wlong != _shadow[TCS34725_CONFIG] ||
+      ((config->enable ^ enable) & TCS34725_ENABLE_WEN);
+  if ((enable & TCS34725_ENABLE_AEN) && timing)
+    updateRegister(TCS34725_ENABLE, enable & ~TCS34725_ENABLE_AEN);
+
+  /* WTIME (0x03) through AIHTH (0x07) */
+  uint8_t wait[5] = {config->wtime, (uint8_t)(config->lowThreshold & 0xFF),
+                     (uint8_t)(config->lowThreshold >> 8),
+                     (uint8_t)(config->highThreshold & 0xFF),
+                     (uint8_t)(config->highThreshold >> 8)};
+  updateRegisters(TCS34725_WTIME, wait, 5);
+
+  /* PERS (0x0C) and CONFIG (0x0D) */
+  uint8_t pers[2] = {config->pers, wlong};
+  updateRegisters(TCS34725_PERS, pers, 2);
+
+  updateRegister(TCS34725_CONTROL, config->gain);
+
+  /* ATIME (0x01) before ENABLE (0x00), even though they are adjacent, so an
+     integration started by setting AEN uses the new integration time */
+  updateRegister(TCS34725_ATIME, config->atime);
+  updateRegister(TCS34725_ENABLE, config->enable);
+  if (timing && _measuring)
+    _sampleDeadline = _cycleEnd + tcs34725PollMargin;
+
+  _tcs34725IntegrationTime = config->atime;
+  _tcs34725Gain = config->gain;
+  updateDerived();
+}
+
+/*!
+ *  @brief  Gets the current configuration without any I2C traffic
+ *  @param  *config
+ *          Configuration to fill
+ */
+void Adafruit_TCS34725::getConfig(tcs34725Config_t *config) {
+  config->enable = _shadow[TCS34725_ENABLE];
+  config->atime = _shadow[TCS34725_ATIME];
+  config->wtime = _shadow[TCS34725_WTIME];
+  config->wlong = (_shadow[TCS34725_CONFIG] & TCS34725_CONFIG_WLONG) != 0;
+  config->pers = _shadow[TCS34725_PERS];
+  config->lowThreshold =
+      (uint16_t(_shadow[TCS34725_AILTH]) << 8) | _shadow[TCS34725_AILTL];
+  config->highThreshold =
+      (uint16_t(_shadow[TCS34725_AIHTH]) << 8) | _shadow[TCS34725_AIHTL];
+  config->gain = (tcs34725Gain_t)(_shadow[TCS34725_CONTROL] & 0x03);
+}
+
+/*!
+ *  @brief  Reads the raw red, green, blue and clear channel values
+ *  @param  *r
+ *          Red value
+ *  @param  *g
+ *          Green value
+ *  @param  *b
+ *          Blue value
+ *  @param  *c
+ *          Clear channel value
+ */
+void Adafruit_TCS34725::getRawData(uint16_t *r, uint16_t *g, uint16_t *b,
+                                   uint16_t *c) {
+  if (!_tcs34725Initialised)
+    init();
+
+  /* Burst read CDATAL..BDATAH (0x14-0x1B) in one transaction */
+  uint8_t buffer[8];
+  readBlock(TCS34725_CDATAL, buffer, 8);
+
+  *c = (uint16_t(buffer[1]) << 8) | buffer[0];
+  *r = (uint16_t(buffer[3]) << 8) | buffer[2];
+  *g = (uint16_t(buffer[5]) << 8) | buffer[4];
+  *b = (uint16_t(buffer[7]) << 8) | buffer[6];
+
+  /* Set a delay for the integration time */
+  wait(integrationDelay());
+}
+
+/*!
+ *  @brief  Starts a fresh integration cycle without blocking. Use
+ *          sampleReady() or poll() to find out when the result is available.
+ */
+void Adafruit_TCS34725::startMeasurement() {
+  if (!_tcs34725Initialised)
+    init();
+
+  /* Toggling AEN restarts the RGBC cycle so the deadline below is exact.
+     PON and AEN may be set together; write8() adds the 2.4ms oscillator
+     warm-up that enable() waits out to the end of the first cycle. */
+  uint8_t reg = _shadow[TCS34725_ENABLE] & ~TCS34725_ENABLE_AEN;
+  write8(TCS34725_ENABLE, reg | TCS34725_ENABLE_PON);
+  write8(TCS34725_ENABLE, reg | TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN);
+  _sampleDeadline = _cycleEnd + tcs34725PollMargin;
+  _measuring = true;
+}
+
+/*!
+ *  @brief  Checks whether the pending measurement has completed. No I2C
+ *          traffic is generated until the integration deadline has passed.
+ *  @return True once the deadline has passed and AVALID is set
+ */
+boolean Adafruit_TCS34725::sampleReady() {
+  if (!_measuring)
+    return false;
+  if ((int32_t)(micros() - _sampleDeadline) < 0)
+    return false;
+
+  return (read8(TCS34725_STATUS) & TCS34725_STATUS_AVALID) != 0;
+}
+
+/*!
+ *  @brief  Non-blocking replacement for getRawData(). Starts a measurement
+ *          if none is pending and returns the result once it is available.
+ *          Never calls delay().
+ *  @param  *r
+ *          Red value
+ *  @param  *g
+ *          Green value
+ *  @param  *b
+ *          Blue value
+ *  @param  *c
+ *          Clear channel value
+ *  @return True if new values were written to r, g, b and c
+ */
+boolean Adafruit_TCS34725::poll(uint16_t *r, uint16_t *g, uint16_t *b,
+                                uint16_t *c) {
+  if (!_measuring) {
+    startMeasurement();
+    return false;
+  }
+  if ((int32_t)(micros() - _sampleDeadline) < 0)
+    return false;
+
+  /* STATUS and data in one read, so AVALID applies to the returned data */
+  tcs34725Snapshot_t snap;
+  if (!getSnapshot(&snap))
+    return false;
+
+  *r = snap.r;
+  *g = snap.g;
+  *b = snap.b;
+  *c = snap.c;
+
+  /* The sensor keeps integrating, so the next result is due one period,
+     including any wait time, after the last deadline. Stepping from the
+     deadline rather than from now keeps the phase; skip whole periods only
+     if the caller has fallen behind. */
+  uint32_t period = getSamplePeriod();
+  _sampleDeadline += period;
+  uint32_t late = micros() - _sampleDeadline;
+  if ((int32_t)late >= 0)
+    _sampleDeadline += (late / period + 1) * period;
+  return true;
+}
+
+/*!
+ *  @brief  Reads STATUS and all RGBC data registers (0x13-0x1B) in a single
+ *          auto-increment transaction, so every channel comes from the same
+ *          integration cycle and the AVALID/AINT flags describe that cycle.
+ *          Unlike getRawData() this does not wait for the next integration.
+ *  @param  *snap
+ *          Snapshot to fill
+ *  @return True if AVALID was set, i.e. the data holds a completed cycle
+ */
+boolean Adafruit_TCS34725::getSnapshot(tcs34725Snapshot_t *snap) {
+  if (!_tcs34725Initialised)
+    init();
+
+  uint8_t buffer[9];
+  readBlock(TCS34725_STATUS, buffer, 9);
+
+  snap->status = buffer[0];
+  snap->c = (uint16_t(buffer[2]) << 8) | buffer[1];
+  snap->r = (uint16_t(buffer[4]) << 8) | buffer[3];
+  snap->g = (uint16_t(buffer[6]) << 8) | buffer[5];
+  snap->b = (uint16_t(buffer[8]) << 8) | buffer[7];
+
+  return (snap->status & TCS34725_STATUS_AVALID) != 0;
+}
+
+/*!
+ *  @brief  Reads a timestamped sample with STATUS and all RGBC data in a
+ *          single burst, as getSnapshot() does, and tags it with the
+ *          integration time, gain, saturation state and configuration
+ *          generation in effect. The timestamp is the end of the
+ *          integration the data came from, estimated from the nominal cycle
+ *          timing, not the time of the read. If AVALID is clear the data
+ *          does not belong to the tagged setting and the sample must be
+ *          discarded. Any dark offset captured for the current setting is
+ *          subtracted; the saturation flag refers to the raw clear count.
+ *  @param  *sample
+ *          Sample to fill
+ *  @return True if AVALID was set, i.e. the data holds a completed cycle
+ */
+boolean Adafruit_TCS34725::getSample(tcs34725Sample_t *sample) {
+  tcs34725Snapshot_t snap;
+  boolean valid = getSnapshot(&snap);
+  makeSample(&snap, sample);
+  return valid;
+}
+
+/*!
+ *  @brief  Builds a sample from a raw snapshot, as described for getSample()
+ *  @param  *snap
+ *          Raw snapshot
+ *  @param  *sample
+ *          Sample to fill
+ */
+void Adafruit_TCS34725::makeSample(const tcs34725Snapshot_t *snap,
+                                   tcs34725Sample_t *sample) {
+  /* Step the end of the first cycle after AEN was set forward to the most
+     recent cycle end. Keeping the reference recent stops micros() wrapping
+     from shifting the phase. */
+  uint32_t age = 0;
+  if (_shadow[TCS34725_ENABLE] & TCS34725_ENABLE_AEN) {
+    uint32_t elapsed = micros() - _cycleEnd;
+    if ((int32_t)elapsed >= 0) {
+      uint32_t period = getSamplePeriod();
+      _cycleEnd += elapsed / period * period;
+      age = elapsed % period;
+    }
+  }
+  sample->timestamp = millis() - age / 1000;
+  sample->c = snap->c;
+  sample->r = snap->r;
+  sample->g = snap->g;
+  sample->b = snap->b;
+  sample->generation = _generation;
+  sample->status = snap->status;
+  sample->atime = _tcs34725IntegrationTime;
+  sample->gain = _tcs34725Gain;
+  sample->saturated = snap->c >= _saturation75;
+  subtractDark(&sample->r, &sample->g, &sample->b, &sample->c);
+}
+
+/*!
+ *  @brief  Gets the configuration generation, which changes every time the
+ *          integration time or gain does, and only then. Samples with the
+ *          same generation can be compared directly; the count wraps after
+ *          65536 changes.
+ *  @return Generation number
+ */
+uint16_t Adafruit_TCS34725::getConfigGeneration() { return _generation; }
+
+/*!
+ *  @brief  Converts a sample to count rates using the integration time and
+ *          gain it was captured with, so readings taken before and after a
+ *          range change can be compared and filtered together
+ *  @param  *sample
+ *          Sample to convert
+ *  @param  *rate
+ *          Destination for the counts/ms/gain values
+ */
+void Adafruit_TCS34725::normalizeSample(const tcs34725Sample_t *sample,
+                                        tcs34725Rate_t *rate) {
+  /* The cached scale is for the current setting. The sample's own setting
+     is compared rather than its generation, which wraps. */
+  uint32_t scale;
+  if (sample->atime == _tcs34725IntegrationTime &&
+      sample->gain == _tcs34725Gain) {
+    if (!_rateScale)
+      _rateScale = rateScale(_tcs34725IntegrationTime, _tcs34725Gain);
+    scale = _rateScale;
+  } else {
+    scale = rateScale(sample->atime, sample->gain);
+  }
+
+  rate->timestamp = sample->timestamp;
+  rate->c = ((uint64_t)sample->c * scale) >> 16;
+  rate->r = ((uint64_t)sample->r * scale) >> 16;
+  rate->g = ((uint64_t)sample->g * scale) >> 16;
+  rate->b = ((uint64_t)sample->b * scale) >> 16;
+  rate->saturated = sample->saturated;
+}
+
+/*!
+ *  @brief  Reads a sample with getSample() and converts it to count rates
+ *  @param  *rate
+ *          Destination for the counts/ms/gain values
+ *  @return True if AVALID was set, i.e. the data holds a completed cycle
+ */
+boolean Adafruit_TCS34725::getNormalizedSample(tcs34725Rate_t *rate) {
+  tcs34725Sample_t sample;
+  boolean valid = getSample(&sample);
+  normalizeSample(&sample, rate);
+  return valid;
+}
+
+/*!
+ *  @brief  Reads the raw red, green, blue and clear channel values in
+ *          one-shot mode (e.g., wakes from sleep, takes measurement, enters
+ *          sleep)
+ *  @param  *r
+ *          Red value
+ *  @param  *g
+ *          Green value
+ *  @param  *b
+ *          Blue value
+ *  @param  *c
+ *          Clear channel value
+ */
+void Adafruit_TCS34725::getRawDataOneShot(uint16_t *r, uint16_t *g, uint16_t *b,
+                                          uint16_t *c) {
+  if (!_tcs34725Initialised)
+    init();
+
+  uint32_t start = micros();
+
+  /* Same power-up sequence as enable(), followed by exactly one integration
+     period rather than the two that enable() + getRawData() would wait */
+  uint8_t reg = _shadow[TCS34725_ENABLE] & ~TCS34725_ENABLE_AEN;
+  write8(TCS34725_ENABLE, reg | TCS34725_ENABLE_PON);
+  wait(3);
+  write8(TCS34725_ENABLE, reg | TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN);
+  wait(integrationDelay());
+
+  /* The internal oscillator may run slightly slow, so allow a few extra
+     milliseconds for AVALID before giving up and using what is there */
+  tcs34725Snapshot_t snap;
+  for (uint8_t tries = 0; !getSnapshot(&snap) && tries < 10; tries++)
+    wait(1);
+
+  disable();
+  _awakeTime = micros() - start;
+
+  *r = snap.r;
+  *g = snap.g;
+  *b = snap.b;
+  *c = snap.c;
+}
+
+/*!
+ *  @brief  Reads the raw channel values averaged over approximately two
+ *          mains ripple periods (20ms at 50Hz, 16.67ms at 60Hz), which
+ *          suppresses lamp flicker without needing a 100ms+ integration. The
+ *          sensor runs 2.4ms integrations back to back and each one is
+ *          accumulated as it completes. Neither window is a whole number of
+ *          cycles, so the cycle that straddles the end is weighted by the
+ *          fraction that falls inside it. Its light is not spread evenly,
+ *          so up to 1.9% (50Hz) or 0.6% (60Hz) of the ripple amplitude
+ *          remains, depending on phase. For exact cancellation use
+ *          setRippleFreeIntegrationTime(). The previous configuration is
+ *          restored afterwards.
+ *  @param  *r
+ *          Red value, as counts for one integration of the window length
+ *  @param  *g
+ *          Green value, as counts for one integration of the window length
+ *  @param  *b
+ *          Blue value, as counts for one integration of the window length
+ *  @param  *c
+ *          Clear channel value, as counts for one integration of the window
+ *          length
+ *  @param  mains
+ *          Local mains frequency
+ *  @return True if every 2.4ms cycle in the window was captured; false if
+ *          the sensor stopped responding or a cycle was missed, e.g. because
+ *          an interrupt held up the MCU
+ */
+boolean Adafruit_TCS34725::getRawDataFlickerFree(uint16_t *r, uint16_t *g,
+                                                 uint16_t *b, uint16_t *c,
+                                                 tcs34725Mains_t mains) {
+  if (!_tcs34725Initialised)
+    init();
+
+  tcs34725Config_t saved;
+  getConfig(&saved);
+  beginFastCycles();
+
+  uint32_t window = (mains == TCS34725_MAINS_60HZ) ? 16667 : 20000;
+  uint32_t covered = 0;
+  uint32_t acc[4] = {0, 0, 0, 0}; /* C/R/G/B, Q8 */
+  uint32_t last = micros();
+  boolean complete = true;
+
+  while (covered < window) {
+    tcs34725Snapshot_t snap;
+    if (!readFastCycle(&snap, &last, covered == 0, &complete))
+      break;
+
+    uint32_t remaining = window - covered;
+    uint32_t weight = (remaining >= 2400) ? 256 : (remaining * 256) / 2400;
+    acc[0] += snap.c * weight;
+    acc[1] += snap.r * weight;
+    acc[2] += snap.g * weight;
+    acc[3] += snap.b * weight;
+    covered += 2400;
+  }
+
+  endFastCycles(&saved);
+
+  *c = (acc[0] + 128) >> 8;
+  *r = (acc[1] + 128) >> 8;
+  *g = (acc[2] + 128) >> 8;
+  *b = (acc[3] + 128) >> 8;
+  return complete;
+}
+
+/*!
+ *  @brief  Detects the local mains frequency from the lamp ripple on the
+ *          clear channel. 300ms of back-to-back 2.4ms integrations are run
+ *          through Goertzel filters at 100Hz and 120Hz; one has to carry at
+ *          least four times the power of the other and an amplitude of 1%
+ *          of the mean level (and at least one count). A successful result
+ *          is cached, so later calls return at once without bus traffic.
+ *          Under daylight or DC-driven LEDs there is no ripple to find and
+ *          detection fails, which is also harmless for flicker.
+ *  @param  *mains
+ *          Set to the detected frequency on success
+ *  @return True if the mains frequency is known
+ */
+boolean Adafruit_TCS34725::detectMains(tcs34725Mains_t *mains) {
+  if (!_mainsKnown) {
+    if (!_tcs34725Initialised)
+      init();
+
+    tcs34725Config_t saved;
+    getConfig(&saved);
+    beginFastCycles();
+
+    float s100[2] = {0, 0}, s120[2] = {0, 0};
+    uint32_t sum = 0;
+    uint32_t last = micros();
+    boolean complete = true;
+    uint8_t n;
+
+    for (n = 0; n < tcs34725MainsSamples; n++) {
+      tcs34725Snapshot_t snap;
+      if (!readFastCycle(&snap, &last, n == 0, &complete))
+        break;
+      sum += snap.c;
+
+      float x = snap.c;
+      float v = x + tcs34725Goertzel100 * s100[0] - s100[1];
+      s100[1] = s100[0];
+      s100[0] = v;
+      v = x + tcs34725Goertzel120 * s120[0] - s120[1];
+      s120[1] = s120[0];
+      s120[0] = v;
+    }
+
+    endFastCycles(&saved);
+
+    if (complete && n == tcs34725MainsSamples) {
+      float p100 = s100[0] * s100[0] + s100[1] * s100[1] -
+                   tcs34725Goertzel100 * s100[0] * s100[1];
+      float p120 = s120[0] * s120[0] + s120[1] * s120[1] -
+                   tcs34725Goertzel120 * s120[0] * s120[1];
+      float peak = (p100 > p120) ? p100 : p120;
+
+      /* Amplitude is 2 sqrt(p) / N; compare squares to avoid the sqrt */
+      float mean = (float)sum / n;
+      float minimum = (mean > 100) ? mean / 100 : 1;
+      boolean strong = 4 * peak >= minimum * minimum * n * n;
+
+      if (strong && p100 >= 4 * p120) {
+        _mains = TCS34725_MAINS_50HZ;
+        _mainsKnown = true;
+      } else if (strong && p120 >= 4 * p100) {
+        _mains = TCS34725_MAINS_60HZ;
+        _mainsKnown = true;
+      }
+    }
+  }
 
-  /* Set default integration time and gain */
-  setIntegrationTime(_tcs34725IntegrationTime);
-  setGain(_tcs34725Gain);
+  if (_mainsKnown)
+    *mains = _mains;
+  return _mainsKnown;
+}
 
-  /* Note: by default, the device is in power down mode on bootup */
-  enable();
+/*!
+ *  @brief  Sets the shortest integration time that spans a whole number of
+ *          ripple periods at the detected mains frequency: 60ms (6 periods
+ *          of 100Hz) or 300ms (36 periods of 120Hz). For lower latency at
+ *          60Hz use getRawDataFlickerFree().
+ *  @return True if the mains frequency was detected and the integration
+ *          time changed; false leaves it as it was
+ */
+boolean Adafruit_TCS34725::setRippleFreeIntegrationTime() {
+  tcs34725Mains_t mains;
+  if (!detectMains(&mains))
+    return false;
 
+  setIntegrationTime((mains == TCS34725_MAINS_60HZ)
+                         ? TCS34725_INTEGRATIONTIME_300MS
+                         : TCS34725_INTEGRATIONTIME_60MS);
   return true;
 }
 
 /*!
- *  @brief  Sets the integration time for the TC34725
- *  @param  it
- *          Integration Time
+ *  @brief  Switches to back-to-back 2.4ms integrations with STATUS.AINT set
+ *          by every cycle, for readFastCycle(). AIEN is left off so the INT
+ *          pin does not fire, and AEN is toggled so the first cycle starts
+ *          afresh at the new integration time.
  */
-void Adafruit_TCS34725::setIntegrationTime(uint8_t it) {
-  if (!_tcs34725Initialised)
-    begin();
+void Adafruit_TCS34725::beginFastCycles() {
+  tcs34725Config_t fast;
+  getConfig(&fast);
+  fast.enable = TCS34725_ENABLE_PON;
+  fast.atime = TCS34725_INTEGRATIONTIME_2_4MS;
+  fast.pers = TCS34725_PERS_NONE;
+  applyConfig(&fast);
+  wait(3);
+  write8(TCS34725_ENABLE, fast.enable | TCS34725_ENABLE_AEN);
+  clearInterrupt();
+}
 
-  /* Update the timing register */
-  write8(TCS34725_ATIME, it);
+/*!
+ *  @brief  Waits for the next cycle started by beginFastCycles() to
+ *          complete, then reads and acknowledges it
+ *  @param  *snap
+ *          Snapshot to fill
+ *  @param  *last
+ *          micros() of the previous result, updated on return
+ *  @param  first
+ *          True for the first cycle, which is not checked for a gap
+ *  @param  *complete
+ *          Cleared if a result was overwritten before it could be read
+ *  @return False if no cycle completed within 10ms
+ */
+boolean Adafruit_TCS34725::readFastCycle(tcs34725Snapshot_t *snap,
+                                         uint32_t *last, boolean first,
+                                         boolean *complete) {
+  for (;;) {
+    getSnapshot(snap);
+    if (snap->status & TCS34725_STATUS_AINT)
+      break;
+    /* Nothing new yet; give up if well over one cycle has passed */
+    if (micros() - *last > 10000) {
+      *complete = false;
+      return false;
+    }
+    delayMicroseconds(200);
+  }
+  clearInterrupt();
 
-  /* Update value placeholders */
-  _tcs34725IntegrationTime = it;
+  /* AINT stays set until cleared, so a gap of more than 1.5 cycles means a
+     result was overwritten before it could be read */
+  uint32_t now = micros();
+  if (!first && now - *last > 3600)
+    *complete = false;
+  *last = now;
+  return true;
 }
 
 /*!
- *  @brief  Adjusts the gain on the TCS34725
- *  @param  gain
- *          Gain (sensitivity to light)
+ *  @brief  Restores the configuration saved before beginFastCycles() and
+ *          restarts integration at the restored integration time
+ *  @param  *saved
+ *          Configuration to restore
  */
-void Adafruit_TCS34725::setGain(tcs34725Gain_t gain) {
+void Adafruit_TCS34725::endFastCycles(const tcs34725Config_t *saved) {
+  /* Dropping AEN first makes applyConfig() restart the cycle */
+  write8(TCS34725_ENABLE, TCS34725_ENABLE_PON);
+  applyConfig(saved);
+}
+
+/*!
+ *  @brief  Gets how long the sensor was powered up during the most recent
+ *          getRawDataOneShot() call
+ *  @return Awake time in microseconds
+ */
+uint32_t Adafruit_TCS34725::getAwakeTime() { return _awakeTime; }
+
+/*!
+ *  @brief  Starts continuous, duty-cycled measurement. The wait timer puts
+ *          the sensor into its low-power wait state between integrations,
+ *          so a new result appears every period without any I2C traffic or
+ *          MCU involvement. The wait is rounded to the nearest 2.4ms step,
+ *          or 28.8ms step with WLONG for waits over 614ms, and limited to
+ *          256 x 28.8ms = 7.37s.
+ *  @param  ms
+ *          Requested time from the start of one integration to the start of
+ *          the next. Periods no longer than the integration time turn the
+ *          wait timer off.
+ *  @return Effective sample period in microseconds
+ */
+uint32_t Adafruit_TCS34725::setSamplePeriod(uint32_t ms) {
+  /* The shadow registers hold the configuration only after init() */
   if (!_tcs34725Initialised)
-    begin();
+    init();
 
-  /* Update the timing register */
-  write8(TCS34725_CONTROL, gain);
+  tcs34725Config_t config;
+  getConfig(&config);
 
-  /* Update value placeholders */
-  _tcs34725Gain = gain;
+  /* The longest wait the timer can produce is 256 x 28.8ms */
+  uint32_t integration = (256 - config.atime) * 2400UL;
+  uint32_t longest = (integration + 256 * 28800UL) / 1000;
+  if (ms > longest)
+    ms = longest;
+
+  uint32_t period = ms * 1000;
+  uint32_t steps = 0;
+
+  config.wlong = false;
+  if (period > integration) {
+    uint32_t wait = period - integration;
+    steps = (wait + 1200) / 2400;
+    if (steps > 256) {
+      config.wlong = true;
+      steps = (wait + 14400) / 28800;
+      if (steps > 256)
+        steps = 256;
+    }
+  }
+
+  config.enable |= TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN;
+  if (steps) {
+    config.enable |= TCS34725_ENABLE_WEN;
+    config.wtime = 256 - steps;
+  } else {
+    config.enable &= ~TCS34725_ENABLE_WEN;
+  }
+  applyConfig(&config);
+
+  return getSamplePeriod();
 }
 
 /*!
- *  @brief  Reads the raw red, green, blue and clear channel values
- *  @param  *r
- *          Red value
- *  @param  *g
- *          Green value
- *  @param  *b
- *          Blue value
- *  @param  *c
- *          Clear channel value
+ *  @brief  Gets the time between results at the current settings, without
+ *          any I2C traffic
+ *  @return Integration time plus wait time, if enabled, in microseconds
  */
-void Adafruit_TCS34725::getRawData(uint16_t *r, uint16_t *g, uint16_t *b,
-                                   uint16_t *c) {
-  if (!_tcs34725Initialised)
-    begin();
+uint32_t Adafruit_TCS34725::getSamplePeriod() {
+  uint32_t period = (256 - _shadow[TCS34725_ATIME]) * 2400UL;
 
-  *c = read16(TCS34725_CDATAL);
-  *r = read16(TCS34725_RDATAL);
-  *g = read16(TCS34725_GDATAL);
-  *b = read16(TCS34725_BDATAL);
+  if (_shadow[TCS34725_ENABLE] & TCS34725_ENABLE_WEN) {
+    uint32_t wait = (256 - _shadow[TCS34725_WTIME]) * 2400UL;
+    if (_shadow[TCS34725_CONFIG] & TCS34725_CONFIG_WLONG)
+      wait *= 12;
+    period += wait;
+  }
+  return period;
+}
 
-  /* Set a delay for the integration time */
-  /* 12/5 = 2.4, add 1 to account for integer truncation */
-  delay((256 - _tcs34725IntegrationTime) * 12 / 5 + 1);
+/*!
+ *  @brief  Gets the rate at which new results are produced
+ *  @return Samples per second
+ */
+float Adafruit_TCS34725::getSampleRate() {
+  return 1000000.0F / getSamplePeriod();
 }
 
 /*!
- *  @brief  Reads the raw red, green, blue and clear channel values in
- *          one-shot mode (e.g., wakes from sleep, takes measurement, enters
- *          sleep)
- *  @param  *r
- *          Red value
- *  @param  *g
- *          Green value
- *  @param  *b
- *          Blue value
- *  @param  *c
- *          Clear channel value
+ *  @brief  Estimates the average supply current of the sensor from the
+ *          datasheet typical figures (235uA active, 65uA waiting, 2.5uA
+ *          asleep) and the duty cycle set by the integration and wait times
+ *  @return Average current in microamps
  */
-void Adafruit_TCS34725::getRawDataOneShot(uint16_t *r, uint16_t *g, uint16_t *b,
-                                          uint16_t *c) {
-  if (!_tcs34725Initialised)
-    begin();
+float Adafruit_TCS34725::getAverageCurrent() {
+  if (!(_shadow[TCS34725_ENABLE] & TCS34725_ENABLE_PON))
+    return tcs34725SleepCurrent;
+  if (!(_shadow[TCS34725_ENABLE] & TCS34725_ENABLE_AEN))
+    return tcs34725WaitCurrent;
 
-  enable();
-  getRawData(r, g, b, c);
-  disable();
+  uint32_t period = getSamplePeriod();
+  uint32_t integration = (256 - _shadow[TCS34725_ATIME]) * 2400UL;
+  return (tcs34725ActiveCurrent * integration +
+          tcs34725WaitCurrent * (period - integration)) /
+         period;
 }
 
 /*!
@@ -298,14 +1737,90 @@ uint16_t Adafruit_TCS34725::calculateColorTemperature(uint16_t r, uint16_t g,
   /* 3. Use McCamy's formula to determine the CCT    */
   n = (xc - 0.3320F) / (0.1858F - yc);
 
-  /* Calculate the final CCT */
-  cct =
-      (449.0F * powf(n, 3)) + (3525.0F * powf(n, 2)) + (6823.3F * n) + 5520.33F;
+  /* Calculate the final CCT (Horner form, avoids going through pow()) */
+  cct = ((449.0F * n + 3525.0F) * n + 6823.3F) * n + 5520.33F;
 
   /* Return the results in degrees Kelvin */
   return (uint16_t)cct;
 }
 
+/*!
+ *  @brief  Integer-only version of calculateColorTemperature() for targets
+ *          without an FPU. McCamy's n is worked out exactly from the same
+ *          matrix and the cubic is evaluated in Q14. The cubic is only
+ *          monotonic for n above -1.28, so n is clamped to +/-1 and results
+ *          are limited to 1773K-16317K. With that clamp the result is within
+ *          1K of the formula evaluated in double precision for any input.
+ *          The float version can be over 0.2% out for colours where the
+ *          matrix terms nearly cancel, and does not clamp n.
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @return Color temperature in degrees Kelvin
+ */
+uint16_t Adafruit_TCS34725::calculateColorTemperature_fixed(uint16_t r,
+                                                            uint16_t g,
+                                                            uint16_t b) {
+  if (r == 0 && g == 0 && b == 0) {
+    return 0;
+  }
+
+  /* 1.-3. n = (xc - 0.3320) / (0.1858 - yc) = (X - 0.332S) / (0.1858S - Y)
+           with S = X + Y + Z. Both are linear in R, G and B, and with the
+           matrix coefficients x 1e9 their coefficients are exact integers.
+           The terms nearly cancel for some colours, so they are summed
+           exactly in 64 bits. */
+  int64_t num = 238814000LL * r + 254991120LL * g - 582910000LL * b;
+  int64_t den = 111082900LL * r - 854058428LL * g + 522885000LL * b;
+
+  int32_t n; /* Q14 */
+  if ((num < 0 ? -num : num) >= (den < 0 ? -den : den)) {
+    n = ((num < 0) != (den < 0)) ? -16384L : 16384L;
+  } else {
+    /* |num| < |den|, so both fit in 17 bits once den does */
+    while (den >= 0x20000L || den <= -0x20000L) {
+      num >>= 1;
+      den >>= 1;
+    }
+    /* Rounded to nearest */
+    int32_t a = (int32_t)num * 16384L, d = (int32_t)den;
+    int32_t half = ((d < 0) ? -d : d) / 2;
+    n = (a + ((a < 0) ? -half : half)) / d;
+  }
+
+  /* Calculate the final CCT in Q14, pre-shifting to stay within 32 bits */
+  int32_t cct = 449L * n + (3525L << 14);
+  cct = (((cct >> 11) * n) >> 3) + 111792947L; /* 6823.3 << 14 */
+  cct = (((cct >> 12) * n) >> 2) + 90445087L;  /* 5520.33 << 14 */
+
+  return (uint16_t)(cct >> 14);
+}
+
+/*!
+ *  @brief  Converts the raw R/G/B/C values to lux using the DN40 algorithm
+ *          from Taos (now AMS), using only integer math. Coefficients are
+ *          the DN40 values (R 0.136, G 1.0, B -0.444, DF 310, GA 1); the
+ *          result is within 1 lux plus 0.15 counts' worth of lux of the
+ *          calculation in double precision. At 2.4ms and 1x one count is
+ *          129 lux.
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Clear channel value
+ *  @return Lux value, at the current gain and integration time
+ */
+uint16_t Adafruit_TCS34725::calculateLux_dn40(uint16_t r, uint16_t g,
+                                              uint16_t b, uint16_t c) {
+  return dn40Lux(r, g, b, c, _luxDivisor);
+}
+
 /*!
  *  @brief  Converts the raw R/G/B values to color temperature in degrees
  *          Kelvin using the algorithm described in DN40 from Taos (now AMS).
@@ -323,34 +1838,6 @@ uint16_t Adafruit_TCS34725::calculateColorTemperature_dn40(uint16_t r,
                                                            uint16_t g,
                                                            uint16_t b,
                                                            uint16_t c) {
-  uint16_t r2, b2; /* RGB values minus IR component */
-  uint16_t sat;    /* Digital saturation level */
-  uint16_t ir;     /* Inferred IR content */
-
-  if (c == 0) {
-    return 0;
-  }
-
-  /* Analog/Digital saturation:
-   *
-   * (a) As light becomes brighter, the clear channel will tend to
-   *     saturate first since R+G+B is approximately equal to C.
-   * (b) The TCS34725 accumulates 1024 counts per 2.4ms of integration
-   *     time, up to a maximum values of 65535. This means analog
-   *     saturation can occur up to an integration time of 153.6ms
-   *     (64*2.4ms=153.6ms).
-   * (c) If the integration time is > 153.6ms, digital saturation will
-   *     occur before analog saturation. Digital saturation occurs when
-   *     the count reaches 65535.
-   */
-  if ((256 - _tcs34725IntegrationTime) > 63) {
-    /* Track digital saturation */
-    sat = 65535;
-  } else {
-    /* Track analog saturation */
-    sat = 1024 * (256 - _tcs34725IntegrationTime);
-  }
-
   /* Ripple rejection:
    *
    * (a) An integration time of 50ms or multiples of 50ms are required to
@@ -367,36 +1854,11 @@ uint16_t Adafruit_TCS34725::calculateColorTemperature_dn40(uint16_t r,
    *     still be saturating. At integration times >150ms this can be
    *     ignored, but <= 150ms you should calculate the 75% saturation
    *     level to avoid this problem.
+   *
+   * Both levels are worked out by updateDerived() when the integration
+   * time changes.
    */
-  if ((256 - _tcs34725IntegrationTime) <= 63) {
-    /* Adjust sat to 75% to avoid analog saturation if atime < 153.6ms */
-    sat -= sat / 4;
-  }
-
-  /* Check for saturation and mark the sample as invalid if true */
-  if (c >= sat) {
-    return 0;
-  }
-
-  /* AMS RGB sensors have no IR channel, so the IR content must be */
-  /* calculated indirectly. */
-  ir = (r + g + b > c) ? (r + g + b - c) / 2 : 0;
-
-  /* Remove the IR component from the raw RGB values */
-  r2 = r - ir;
-  b2 = b - ir;
-
-  if (r2 == 0) {
-    return 0;
-  }
-
-  /* A simple method of measuring color temp is to use the ratio of blue */
-  /* to red light, taking IR cancellation into account. */
-  uint16_t cct = (3810 * (uint32_t)b2) / /** Color temp coefficient. */
-                     (uint32_t)r2 +
-                 1391; /** Color temp offset. */
-
-  return cct;
+  return dn40ColorTemperature(r, g, b, c, _saturation75);
 }
 
 /*!
@@ -425,13 +1887,13 @@ uint16_t Adafruit_TCS34725::calculateLux(uint16_t r, uint16_t g, uint16_t b) {
  *          Interrupt (True/False)
  */
 void Adafruit_TCS34725::setInterrupt(boolean i) {
-  uint8_t r = read8(TCS34725_ENABLE);
+  uint8_t r = _shadow[TCS34725_ENABLE];
   if (i) {
     r |= TCS34725_ENABLE_AIEN;
   } else {
     r &= ~TCS34725_ENABLE_AIEN;
   }
-  write8(TCS34725_ENABLE, r);
+  updateRegister(TCS34725_ENABLE, r);
 }
 
 /*!
@@ -439,7 +1901,7 @@ void Adafruit_TCS34725::setInterrupt(boolean i) {
  */
 void Adafruit_TCS34725::clearInterrupt() {
   uint8_t buffer[1] = {TCS34725_COMMAND_BIT | 0x66};
-  i2c_dev->write(buffer, 1);
+  busWrite(TCS34725_OP_CLEAR_INT, buffer, 1);
 }
 
 /*!
@@ -450,8 +1912,353 @@ void Adafruit_TCS34725::clearInterrupt() {
  *          High limit
  */
 void Adafruit_TCS34725::setIntLimits(uint16_t low, uint16_t high) {
-  write8(0x04, low & 0xFF);
-  write8(0x05, low >> 8);
-  write8(0x06, high & 0xFF);
-  write8(0x07, high >> 8);
+  uint8_t limits[4] = {(uint8_t)(low & 0xFF), (uint8_t)(low >> 8),
+                       (uint8_t)(high & 0xFF), (uint8_t)(high >> 8)};
+  updateRegisters(TCS34725_AILTL, limits, 4);
+}
+
+/*!
+ *  @brief  Enables interrupt-driven sampling. Attach an ISR for the INT pin
+ *          (active low, open drain) that calls handleInterrupt(), then call
+ *          service() from the main loop to move samples into the queue.
+ *          The I2C read happens in service(), not in the ISR, and the
+ *          sensor only holds the latest result: if service() is not called
+ *          within one cycle of the interrupt, that result is overwritten
+ *          and, with TCS34725_PERS_NONE, the loss is counted by
+ *          getMissedInterrupts().
+ *  @param  *queue
+ *          Queue that receives the samples, or NULL to only track them
+ *  @param  persistence
+ *          Interrupt persistence filter; TCS34725_PERS_NONE interrupts on
+ *          every RGBC cycle
+ */
+void Adafruit_TCS34725::beginInterrupts(Adafruit_TCS34725_SampleQueue *queue,
+                                        uint8_t persistence) {
+  if (!_tcs34725Initialised)
+    init();
+
+  _queue = queue;
+  _intPending = false;
+  _missedInterrupts = 0;
+  _deadband = 0;
+
+  updateRegister(TCS34725_PERS, persistence);
+  setInterrupt(true);
+  clearInterrupt();
+}
+
+/*!
+ *  @brief  Enables report-on-change mode. The clear channel interrupt window
+ *          is centred on the current reading and re-centred on every sample
+ *          service() reads, so the sensor only interrupts (and the MCU and
+ *          bus only wake) when the light level moves by more than the
+ *          deadband for the given number of consecutive cycles. Interrupt
+ *          handling is otherwise the same as for beginInterrupts().
+ *  @param  *queue
+ *          Queue that receives the samples, or NULL to only track them
+ *  @param  deadband
+ *          Half-width of the window as a percentage of the clear reading
+ *  @param  persistence
+ *          Consecutive out-of-window cycles required to interrupt
+ *          (TCS34725_PERS_1_CYCLE or longer)
+ */
+void Adafruit_TCS34725::beginChangeDetection(
+    Adafruit_TCS34725_SampleQueue *queue, uint8_t deadband,
+    uint8_t persistence) {
+  if (persistence == TCS34725_PERS_NONE)
+    persistence = TCS34725_PERS_1_CYCLE;
+
+  beginInterrupts(queue, persistence);
+  _deadband = deadband ? deadband : 1;
+
+  /* With no completed cycle yet this centres on zero, so the first real
+     reading is reported as a change */
+  tcs34725Snapshot_t snap;
+  recentreLimits(getSnapshot(&snap) ? snap.c : 0);
+}
+
+/*!
+ *  @brief  Centres the clear channel interrupt window on a reading, using
+ *          the deadband given to beginChangeDetection()
+ *  @param  c
+ *          Clear channel value
+ */
+void Adafruit_TCS34725::recentreLimits(uint16_t c) {
+  uint16_t band = (uint32_t)c * _deadband / 100;
+  if (band < tcs34725MinDeadband)
+    band = tcs34725MinDeadband;
+
+  uint16_t low = (c > band) ? c - band : 0;
+  uint16_t high = (c < 65535 - band) ? c + band : 65535;
+  setIntLimits(low, high);
+}
+
+/*!
+ *  @brief  Marks new data as ready. Safe to call from an ISR: it does not
+ *          touch the I2C bus.
+ */
+void Adafruit_TCS34725::handleInterrupt() {
+  _intTimestamp = micros();
+  _intPending = true;
+}
+
+/*!
+ *  @brief  Services a pending interrupt: burst-reads STATUS and RGBC, clears
+ *          the interrupt and pushes the timestamped sample into the queue
+ *          given to beginInterrupts(). Call this from the main loop. If a
+ *          range change has restarted the cycle since the interrupt, AVALID
+ *          is clear and nothing is queued.
+ *
+ *          INT stays asserted until it is cleared here, so a falling-edge
+ *          ISR runs once per service() however many cycles complete in
+ *          between. The cycles that completed after the interrupt are
+ *          worked out from the time it has waited; when every cycle
+ *          interrupts (TCS34725_PERS_NONE) each one overwrote an unread
+ *          result and is counted by getMissedInterrupts().
+ *  @return True if an interrupt was serviced
+ */
+boolean Adafruit_TCS34725::service() {
+  if (!_intPending)
+    return false;
+
+  uint32_t intTime;
+  noInterrupts();
+  intTime = _intTimestamp;
+  _intPending = false;
+  interrupts();
+
+  uint32_t period = getSamplePeriod();
+  uint32_t overwritten = (micros() - intTime) / period;
+
+  tcs34725Snapshot_t snap;
+  if (!getSnapshot(&snap)) {
+    /* The cycle was restarted by a range change after the interrupt; its
+       data is not valid for the new setting */
+    clearInterrupt();
+    return true;
+  }
+  if ((_shadow[TCS34725_PERS] & 0x0F) == TCS34725_PERS_NONE) {
+    uint32_t missed = _missedInterrupts + overwritten;
+    _missedInterrupts = (missed > 0xFFFF) ? 0xFFFF : missed;
+  }
+  /* The data is from the latest of the cycles, not the one that interrupted */
+  intTime += overwritten * period;
+  /* Move the window before clearing, so the next cycle is compared against
+     the new level. The thresholds apply to raw counts. */
+  if (_deadband)
+    recentreLimits(snap.c);
+  clearInterrupt();
+
+  tcs34725Sample_t sample;
+  makeSample(&snap, &sample);
+  sample.timestamp = millis() - (micros() - intTime) / 1000;
+
+  if (_queue)
+    _queue->push(&sample);
+
+  return true;
+}
+
+/*!
+ *  @brief  Gets the number of results the sensor produced but service() never
+ *          read, because a later cycle overwrote them first. Only counted
+ *          when every cycle interrupts (TCS34725_PERS_NONE).
+ *  @return Missed result count since beginInterrupts(), saturating at 65535
+ */
+uint16_t Adafruit_TCS34725::getMissedInterrupts() { return _missedInterrupts; }
+
+/*!
+ *  @brief  Constructor
+ *  @param  *buffer
+ *          Storage for the samples
+ *  @param  size
+ *          Number of elements in buffer (the queue holds size - 1 samples).
+ *          Sizes below 2 give a queue that drops every sample.
+ */
+Adafruit_TCS34725_SampleQueue::Adafruit_TCS34725_SampleQueue(
+    tcs34725Sample_t *buffer, uint8_t size)
+    : _buffer(buffer), _size(size), _head(0), _tail(0), _overruns(0) {
+  /* One slot is always kept empty, so fewer than two hold nothing */
+  if (!buffer || size < 2)
+    _size = 0;
+}
+
+/*!
+ *  @brief  Adds a sample. Must only be called from the producer context.
+ *  @param  *sample
+ *          Sample to copy into the queue
+ *  @return True if queued, false if the queue was full and the sample was
+ *          dropped
+ */
+boolean Adafruit_TCS34725_SampleQueue::push(const tcs34725Sample_t *sample) {
+  uint8_t head = _head;
+  uint8_t next = (head + 1 == _size) ? 0 : head + 1;
+  if (_size == 0 || next == _tail) {
+    _overruns++;
+    return false;
+  }
+
+  _buffer[head] = *sample;
+  /* Publish the slot only after its contents are written */
+  tcs34725Barrier();
+  _head = next;
+  return true;
+}
+
+/*!
+ *  @brief  Removes the oldest sample. Must only be called from the consumer
+ *          context.
+ *  @param  *sample
+ *          Destination for the sample
+ *  @return True if a sample was returned, false if the queue was empty
+ */
+boolean Adafruit_TCS34725_SampleQueue::pop(tcs34725Sample_t *sample) {
+  uint8_t tail = _tail;
+  if (tail == _head)
+    return false;
+
+  *sample = _buffer[tail];
+  /* Release the slot only after its contents are read */
+  tcs34725Barrier();
+  _tail = (tail + 1 == _size) ? 0 : tail + 1;
+  return true;
+}
+
+/*!
+ *  @brief  Gets the number of queued samples
+ *  @return Samples waiting to be popped
+ */
+uint8_t Adafruit_TCS34725_SampleQueue::available() {
+  uint8_t head = _head, tail = _tail;
+  return (head >= tail) ? head - tail : _size - tail + head;
+}
+
+/*!
+ *  @brief  Gets the number of samples dropped because the queue was full
+ *  @return Overrun count
+ */
+uint32_t Adafruit_TCS34725_SampleQueue::getOverruns() { return _overruns; }
+
+/*!
+ *  @brief  Constructor
+ *  @param  *tcs
+ *          Sensor to control; must already be initialised with begin()
+ *  @param  maxIt
+ *          Longest integration time the engine may select
+ */
+Adafruit_TCS34725_Autorange::Adafruit_TCS34725_Autorange(Adafruit_TCS34725 *tcs,
+                                                         uint8_t maxIt)
+    : _tcs(tcs), _maxCycles(256 - maxIt), _converging(false),
+      _convergeStart(0) {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+/*!
+ *  @brief  Non-blocking read with autoranging, built on
+ *          Adafruit_TCS34725::poll(). Readings that trigger a range change
+ *          are discarded and a fresh integration is started at the new
+ *          setting, so no settling delay is needed.
+ *  @param  *r
+ *          Red value
+ *  @param  *g
+ *          Green value
+ *  @param  *b
+ *          Blue value
+ *  @param  *c
+ *          Clear channel value
+ *  @return True if new in-range values were written to r, g, b and c
+ */
+boolean Adafruit_TCS34725_Autorange::poll(uint16_t *r, uint16_t *g,
+                                          uint16_t *b, uint16_t *c) {
+  if (!_tcs->poll(r, g, b, c))
+    return false;
+
+  if (update(*c)) {
+    _tcs->startMeasurement();
+    return false;
+  }
+
+  if (_converging) {
+    _converging = false;
+    _stats.lastLatency = millis() - _convergeStart;
+    if (_stats.lastLatency > _stats.maxLatency)
+      _stats.maxLatency = _stats.lastLatency;
+  }
+  return true;
+}
+
+/*!
+ *  @brief  Checks a clear channel reading taken at the sensor's current
+ *          settings and, if it is outside 25-80% of the usable range,
+ *          reprograms gain and integration time. The caller must discard
+ *          data until a new integration has completed.
+ *  @param  c
+ *          Clear channel value
+ *  @return True if the gain or integration time was changed
+ */
+boolean Adafruit_TCS34725_Autorange::update(uint16_t c) {
+  tcs34725Gain_t gain = _tcs->getGain();
+  uint16_t cycles = 256 - _tcs->getIntegrationTime();
+
+  /* Usable range, including the 75% ripple margin used by the DN40 code */
+  uint16_t ceiling = _tcs->getSaturation75();
+  if (c >= ceiling / 4 && c <= ceiling - ceiling / 5)
+    return false;
+
+  tcs34725Gain_t bestGain = TCS34725_GAIN_1X;
+  uint16_t bestCycles = 1;
+  if (c == 0) {
+    /* Dark: no rate to extrapolate from, go to maximum sensitivity */
+    bestGain = TCS34725_GAIN_60X;
+    bestCycles = _maxCycles;
+  } else if (c < ceiling) {
+    /* Predicted count at gain g and n cycles is c * g * n / (g0 * n0). Aim
+       for half the usable range: 384 counts per cycle up to 63 cycles,
+       32767 counts beyond that. */
+    uint32_t p0 = (uint32_t)tcs34725GainFactor[gain] * cycles;
+    uint32_t bestProduct = 0;
+    for (int8_t i = TCS34725_GAIN_60X; i >= TCS34725_GAIN_1X; i--) {
+      uint32_t rate = (uint32_t)c * tcs34725GainFactor[i];
+      uint32_t n = 0;
+      uint32_t nLong = (32767UL * p0) / rate;
+      if (nLong >= 64 && _maxCycles >= 64)
+        n = nLong;
+      else if (rate <= 384UL * p0)
+        n = 63;
+      if (n > _maxCycles)
+        n = _maxCycles;
+      uint32_t product = n * tcs34725GainFactor[i];
+      if (n > 0 && product > bestProduct) {
+        bestProduct = product;
+        bestGain = (tcs34725Gain_t)i;
+        bestCycles = n;
+      }
+    }
+  }
+  /* Saturated readings carry no usable rate, so fall back to the least
+     sensitive setting; the next reading then predicts exactly */
+
+  if (bestGain == gain && bestCycles == cycles)
+    return false;
+
+  if (!_converging) {
+    _converging = true;
+    _convergeStart = millis();
+    _stats.lastSteps = 0;
+  }
+  _stats.lastSteps++;
+  _stats.rangeChanges++;
+
+  _tcs->setGain(bestGain);
+  _tcs->setIntegrationTime(256 - bestCycles);
+  return true;
+}
+
+/*!
+ *  @brief  Gets the convergence statistics
+ *  @param  *stats
+ *          Statistics to fill
+ */
+void Adafruit_TCS34725_Autorange::getStats(tcs34725AutorangeStats_t *stats) {
+  *stats = _stats;
 }
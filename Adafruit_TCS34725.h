@@ -33,6 +33,7 @@
 #ifndef _TCS34725_H_
 #define _TCS34725_H_
 
+#if defined(ARDUINO)
 #if ARDUINO >= 100
 #include <Arduino.h>
 #else
@@ -40,9 +41,35 @@
 #endif
 
 #include <Adafruit_I2CDevice.h>
+#else
+/* Host build, e.g. on Linux with Adafruit_TCS34725_LinuxI2C: no Arduino core
+   or BusIO. The platform provides the timing calls below. */
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef bool boolean; ///< Arduino's boolean type
+
+/** @return Milliseconds since start-up */
+unsigned long millis(void);
+/** @return Microseconds since start-up */
+unsigned long micros(void);
+/** @param ms Milliseconds to block for */
+void delay(unsigned long ms);
+/** @param us Microseconds to block for */
+void delayMicroseconds(unsigned int us);
+/** @brief Enters a section handleInterrupt() must not run in */
+void noInterrupts(void);
+/** @brief Leaves a section entered with noInterrupts() */
+void interrupts(void);
+#endif
 
 #define TCS34725_ADDRESS (0x29)     /**< I2C address **/
 #define TCS34725_COMMAND_BIT (0x80) /**< Command bit **/
+#define TCS34725_COMMAND_AUTOINC                                               \
+  (0x20) /**< Command type: auto-increment the register address after each     \
+            byte, so a block of registers can be read in one transaction */
 #define TCS34725_ENABLE (0x00)      /**< Interrupt Enable register */
 #define TCS34725_ENABLE_AIEN (0x10) /**< RGBC Interrupt Enable */
 #define TCS34725_ENABLE_WEN                                                    \
@@ -181,6 +208,47 @@
 #define TCS34725_INTEGRATIONTIME_614MS                                         \
   (0x00) /**< 614.4ms - 256 cycles - Max Count: 65535 */
 
+/** I2C operations tracked by the instrumentation */
+typedef enum {
+  TCS34725_OP_WRITE8,      /**<  write8() */
+  TCS34725_OP_READ8,       /**<  read8() */
+  TCS34725_OP_READ16,      /**<  read16() */
+  TCS34725_OP_READ_BLOCK,  /**<  Auto-increment burst read */
+  TCS34725_OP_WRITE_BLOCK, /**<  Auto-increment burst write */
+  TCS34725_OP_CLEAR_INT,   /**<  clearInterrupt() */
+  TCS34725_OP_COUNT        /**<  Number of operations */
+} tcs34725Op_t;
+
+/*
+ * Define TCS34725_STATS (e.g. with a build flag) to count I2C bytes, NACKs
+ * and delays and keep a per-operation latency histogram. Without it the
+ * instrumentation compiles away completely. The flag changes the layout of
+ * Adafruit_TCS34725, so the library and every sketch file must agree on it;
+ * tcs34725Build_t turns a mismatch into a link error.
+ */
+#ifdef TCS34725_STATS
+#define TCS34725_STATS_BUCKETS                                                 \
+  (8) /**< Latency buckets: < 64us, < 128us, ... < 4096us, longer */
+
+/** Snapshot of the I2C instrumentation counters */
+typedef struct {
+  uint32_t transactions; /**< I2C transactions issued */
+  uint32_t bytes;        /**< Bytes transferred, command bytes included */
+  uint32_t nacks;        /**< Transactions the transport reported as failed */
+  uint32_t delayMs;      /**< Time spent blocked in delay() by the driver */
+  uint16_t latency[TCS34725_OP_COUNT]
+                  [TCS34725_STATS_BUCKETS]; /**< Latency histogram per op */
+} tcs34725Stats_t;
+
+/** Build tag taken by the constructor, naming the TCS34725_STATS setting */
+typedef struct tcs34725BuildWithStats {
+} tcs34725Build_t;
+#else
+/** Build tag taken by the constructor, naming the TCS34725_STATS setting */
+typedef struct tcs34725BuildWithoutStats {
+} tcs34725Build_t;
+#endif
+
 /** Gain settings for TCS34725  */
 typedef enum {
   TCS34725_GAIN_1X = 0x00,  /**<  No gain  */
@@ -189,6 +257,165 @@ typedef enum {
   TCS34725_GAIN_60X = 0x03  /**<  60x gain */
 } tcs34725Gain_t;
 
+/** Mains frequency, for flicker rejection */
+typedef enum {
+  TCS34725_MAINS_50HZ = 0, /**< 100Hz ripple, averaged over 20ms */
+  TCS34725_MAINS_60HZ = 1  /**< 120Hz ripple, averaged over 16.67ms */
+} tcs34725Mains_t;
+
+/** Complete sensor configuration, applied in one go by applyConfig() */
+typedef struct {
+  uint8_t enable;         /**< ENABLE register bits (PON, AEN, WEN, AIEN) */
+  uint8_t atime;          /**< Integration time (TCS34725_INTEGRATIONTIME_*) */
+  uint8_t wtime;          /**< Wait time (TCS34725_WTIME_*) */
+  boolean wlong;          /**< Multiply the wait time by 12 */
+  uint8_t pers;           /**< Interrupt persistence (TCS34725_PERS_*) */
+  uint16_t lowThreshold;  /**< Clear channel lower interrupt threshold */
+  uint16_t highThreshold; /**< Clear channel upper interrupt threshold */
+  tcs34725Gain_t gain;    /**< Gain */
+} tcs34725Config_t;
+
+/** Coherent RGBC reading taken together with the STATUS register */
+typedef struct {
+  uint8_t status; /**< STATUS register (AVALID/AINT) at the time of the read */
+  uint16_t c;     /**< Clear channel value */
+  uint16_t r;     /**< Red channel value */
+  uint16_t g;     /**< Green channel value */
+  uint16_t b;     /**< Blue channel value */
+} tcs34725Snapshot_t;
+
+/** RGBC reading with the context needed to interpret it. Fields are
+    ordered so there is no padding between them. */
+typedef struct {
+  uint32_t timestamp;  /**< millis() at the end of the integration, or when
+                            the data ready interrupt fired */
+  uint16_t c;          /**< Clear channel value */
+  uint16_t r;          /**< Red channel value */
+  uint16_t g;          /**< Green channel value */
+  uint16_t b;          /**< Blue channel value */
+  uint16_t generation; /**< Configuration generation the reading was taken
+                            with, see getConfigGeneration() */
+  uint8_t status;      /**< STATUS register (AVALID/AINT) at the time of read */
+  uint8_t atime;       /**< Integration time (TCS34725_INTEGRATIONTIME_*) */
+  uint8_t gain;        /**< Gain (tcs34725Gain_t) */
+  uint8_t saturated;   /**< Non-zero if c reached getSaturation75() */
+} tcs34725Sample_t;
+
+/** Reading scaled to a count rate, independent of integration time and
+    gain. Channel values are counts per millisecond per unit of gain in
+    unsigned Q16.16 fixed point (65536 = 1 count/ms at 1x). */
+typedef struct {
+  uint32_t timestamp; /**< Copied from the source sample */
+  uint32_t c;         /**< Clear channel rate, Q16.16 */
+  uint32_t r;         /**< Red channel rate, Q16.16 */
+  uint32_t g;         /**< Green channel rate, Q16.16 */
+  uint32_t b;         /**< Blue channel rate, Q16.16 */
+  uint8_t saturated;  /**< Copied from the source sample */
+} tcs34725Rate_t;
+
+/** Dark count baseline for one integration time and gain, see
+    setDarkTable() */
+typedef struct {
+  uint8_t atime; /**< Integration time the offsets apply to */
+  uint8_t gain;  /**< Gain the offsets apply to, 0xFF if the entry is free */
+  uint16_t c;    /**< Clear channel dark count */
+  uint16_t r;    /**< Red channel dark count */
+  uint16_t g;    /**< Green channel dark count */
+  uint16_t b;    /**< Blue channel dark count */
+} tcs34725Dark_t;
+
+/** 3x3 colour correction matrix with offset, applied to R/G/B as
+    out = M x (r, g, b) + offset. Coefficients are Q15 scaled by 2^shift,
+    i.e. each one is m / 2^(15 - shift), so shift = 2 allows values in
+    [-4, 4). */
+typedef struct {
+  int16_t m[3][3];   /**< Coefficients; row 0 gives R, row 1 G, row 2 B */
+  int16_t offset[3]; /**< Added to R/G/B after the matrix, in counts */
+  uint8_t shift;     /**< Coefficient exponent, 0-3 */
+} tcs34725Ccm_t;
+
+/*!
+ *  @brief  Fixed-capacity single-producer/single-consumer sample queue. One
+ *          context may push() while another pop()s without locking, also
+ *          across cores. The storage is provided by the caller and holds
+ *          size - 1 samples, so size must be at least 2.
+ */
+class Adafruit_TCS34725_SampleQueue {
+public:
+  Adafruit_TCS34725_SampleQueue(tcs34725Sample_t *buffer, uint8_t size);
+
+  boolean push(const tcs34725Sample_t *sample);
+  boolean pop(tcs34725Sample_t *sample);
+  uint8_t available();
+  uint32_t getOverruns();
+
+private:
+  tcs34725Sample_t *_buffer; ///< Caller-provided storage
+  uint8_t _size;             ///< Number of slots in _buffer
+  volatile uint8_t _head;    ///< Next slot to write, owned by the producer
+  volatile uint8_t _tail;    ///< Next slot to read, owned by the consumer
+  volatile uint32_t _overruns; ///< Samples dropped because the queue was full
+};
+
+/*!
+ *  @brief  Bus interface used for all register access. It mirrors the part
+ *          of Adafruit_I2CDevice the driver needs, so other buses or a
+ *          simulated device can stand in for the real I2C port.
+ */
+class Adafruit_TCS34725_Transport {
+public:
+  virtual ~Adafruit_TCS34725_Transport() {}
+
+  /*!
+   *  @brief  Prepares the bus and checks that the device responds
+   *  @return True if the device is present
+   */
+  virtual bool begin() = 0;
+
+  /*!
+   *  @brief  Writes a buffer to the device in one transaction
+   *  @param  *buffer
+   *          Bytes to write, starting with the command byte
+   *  @param  len
+   *          Number of bytes
+   *  @return True on success
+   */
+  virtual bool write(const uint8_t *buffer, size_t len) = 0;
+
+  /*!
+   *  @brief  Writes then reads in one combined transaction (repeated start)
+   *  @param  *write_buffer
+   *          Bytes to write, starting with the command byte
+   *  @param  write_len
+   *          Number of bytes to write
+   *  @param  *read_buffer
+   *          Destination for the bytes read
+   *  @param  read_len
+   *          Number of bytes to read
+   *  @return True on success
+   */
+  virtual bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                               uint8_t *read_buffer, size_t read_len) = 0;
+};
+
+#if defined(ARDUINO)
+/*!
+ *  @brief  Default transport, talking to the sensor through Adafruit BusIO
+ */
+class Adafruit_TCS34725_BusIO : public Adafruit_TCS34725_Transport {
+public:
+  Adafruit_TCS34725_BusIO(uint8_t addr, TwoWire *theWire);
+
+  bool begin();
+  bool write(const uint8_t *buffer, size_t len);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len);
+
+private:
+  Adafruit_I2CDevice _dev; ///< Underlying BusIO device
+};
+#endif
+
 /*!
  *  @brief  Class that stores state and functions for interacting with
  *          TCS34725 Color Sensor
@@ -196,34 +423,271 @@ typedef enum {
 class Adafruit_TCS34725 {
 public:
   Adafruit_TCS34725(uint8_t = TCS34725_INTEGRATIONTIME_2_4MS,
-                    tcs34725Gain_t = TCS34725_GAIN_1X);
+                    tcs34725Gain_t = TCS34725_GAIN_1X,
+                    tcs34725Build_t = tcs34725Build_t());
 
+#if defined(ARDUINO)
   boolean begin(uint8_t addr = TCS34725_ADDRESS, TwoWire *theWire = &Wire);
+#endif
+  boolean begin(Adafruit_TCS34725_Transport *transport);
   boolean init();
 
   void setIntegrationTime(uint8_t it);
   void setGain(tcs34725Gain_t gain);
+  uint8_t getIntegrationTime();
+  tcs34725Gain_t getGain();
+  uint16_t getSaturation();
+  uint16_t getSaturation75();
+  float getCountsPerLux();
+  float getMaxLux();
+  void applyConfig(const tcs34725Config_t *config);
+  void getConfig(tcs34725Config_t *config);
   void getRawData(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
+  boolean getSnapshot(tcs34725Snapshot_t *snap);
+  boolean getSample(tcs34725Sample_t *sample);
+  uint16_t getConfigGeneration();
+  void normalizeSample(const tcs34725Sample_t *sample, tcs34725Rate_t *rate);
+  boolean getNormalizedSample(tcs34725Rate_t *rate);
+  boolean calibrateGains(uint8_t samples = 4);
+  boolean setGainRatios(const uint32_t ratios[4]);
+  void getGainRatios(uint32_t ratios[4]);
+  void setDarkTable(tcs34725Dark_t *table, uint8_t size,
+                    boolean clear = true);
+  boolean captureDark(uint8_t samples = 4);
+  void subtractDark(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
+  boolean setColorCorrection(const tcs34725Ccm_t *ccm);
+  void correctColor(tcs34725Sample_t *sample);
+  void correctColor(tcs34725Sample_t *samples, uint16_t count);
   void getRGB(float *r, float *g, float *b);
+  void startMeasurement();
+  boolean sampleReady();
+  boolean poll(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
   void getRawDataOneShot(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
+  boolean getRawDataFlickerFree(uint16_t *r, uint16_t *g, uint16_t *b,
+                                uint16_t *c, tcs34725Mains_t mains);
+  boolean detectMains(tcs34725Mains_t *mains);
+  boolean setRippleFreeIntegrationTime();
+  uint32_t getAwakeTime();
+  uint32_t setSamplePeriod(uint32_t ms);
+  uint32_t getSamplePeriod();
+  float getSampleRate();
+  float getAverageCurrent();
   uint16_t calculateColorTemperature(uint16_t r, uint16_t g, uint16_t b);
   uint16_t calculateColorTemperature_dn40(uint16_t r, uint16_t g, uint16_t b,
                                           uint16_t c);
   uint16_t calculateLux(uint16_t r, uint16_t g, uint16_t b);
+  uint16_t calculateColorTemperature_fixed(uint16_t r, uint16_t g, uint16_t b);
+  uint16_t calculateLux_dn40(uint16_t r, uint16_t g, uint16_t b, uint16_t c);
   void write8(uint8_t reg, uint8_t value);
   uint8_t read8(uint8_t reg);
   uint16_t read16(uint8_t reg);
+  void readBlock(uint8_t reg, uint8_t *buffer, uint8_t len);
+  uint32_t getTransactionCount();
+  void resetTransactionCount();
+#ifdef TCS34725_STATS
+  void getStats(tcs34725Stats_t *stats);
+  void resetStats();
+#endif
   void setInterrupt(boolean flag);
   void clearInterrupt();
+  void beginInterrupts(Adafruit_TCS34725_SampleQueue *queue,
+                       uint8_t persistence = TCS34725_PERS_NONE);
+  void beginChangeDetection(Adafruit_TCS34725_SampleQueue *queue,
+                            uint8_t deadband = 10,
+                            uint8_t persistence = TCS34725_PERS_3_CYCLE);
+  void handleInterrupt();
+  boolean service();
+  uint16_t getMissedInterrupts();
   void setIntLimits(uint16_t l, uint16_t h);
   void enable();
   void disable();
 
+protected:
+  /*!
+   *  @brief  Blocks for a number of milliseconds, accounting for the time if
+   *          TCS34725_STATS is defined
+   *  @param  ms
+   *          Milliseconds to wait
+   */
+  void wait(uint32_t ms) {
+#ifdef TCS34725_STATS
+    _stats.delayMs += ms;
+#endif
+    delay(ms);
+  }
+
+  /*!
+   *  @brief  Integer DN40 lux calculation shared by calculateLux_dn40() and
+   *          Adafruit_TCS34725_Static, which passes a constant divisor
+   *  @param  r
+   *          Red value
+   *  @param  g
+   *          Green value
+   *  @param  b
+   *          Blue value
+   *  @param  c
+   *          Clear channel value
+   *  @param  divisor
+   *          384 x integration cycles x gain factor
+   *  @return Lux value
+   */
+  static inline uint16_t dn40Lux(uint16_t r, uint16_t g, uint16_t b,
+                                 uint16_t c, uint32_t divisor) {
+    /* AMS RGB sensors have no IR channel, so the IR content must be */
+    /* calculated indirectly. */
+    int32_t ir = ((int32_t)r + g + b - c) / 2;
+    if (ir < 0)
+      ir = 0;
+
+    /* 0.136 R' - 0.444 B' in Q16, then add G' (coefficient 1.0) in Q8.
+       G' can be negative, so it is multiplied rather than shifted. */
+    int32_t s = 8913L * (r - ir) - 29098L * (b - ir);
+    s = (g - ir) * 256L + (s >> 8);
+    if (s <= 0)
+      return 0;
+
+    /* lux = s / 256 / CPL, CPL = 2.4ms * cycles * gain / 310
+           = (s / 4) * 775 / (384 * cycles * gain) */
+    uint32_t lux = ((uint32_t)s >> 2) * 775UL / divisor;
+
+    return (lux > 65535) ? 65535 : (uint16_t)lux;
+  }
+
+  /*!
+   *  @brief  DN40 colour temperature calculation shared by
+   *          calculateColorTemperature_dn40() and Adafruit_TCS34725_Static
+   *  @param  r
+   *          Red value
+   *  @param  g
+   *          Green value
+   *  @param  b
+   *          Blue value
+   *  @param  c
+   *          Clear channel value
+   *  @param  sat
+   *          Clear count at and above which the reading is saturated
+   *  @return Color temperature in degrees Kelvin, or 0 if saturated
+   */
+  static inline uint16_t dn40ColorTemperature(uint16_t r, uint16_t g,
+                                              uint16_t b, uint16_t c,
+                                              uint16_t sat) {
+    /* Check for saturation and mark the sample as invalid if true */
+    if (c == 0 || c >= sat)
+      return 0;
+
+    /* AMS RGB sensors have no IR channel, so the IR content must be */
+    /* calculated indirectly. */
+    uint16_t ir = (r + g + b > c) ? (r + g + b - c) / 2 : 0;
+
+    /* Remove the IR component from the raw RGB values */
+    uint16_t r2 = r - ir;
+    uint16_t b2 = b - ir;
+
+    if (r2 == 0)
+      return 0;
+
+    /* A simple method of measuring color temp is to use the ratio of blue */
+    /* to red light, taking IR cancellation into account. */
+    return (3810 * (uint32_t)b2) / /** Color temp coefficient. */
+               (uint32_t)r2 +
+           1391; /** Color temp offset. */
+  }
+
 private:
-  Adafruit_I2CDevice *i2c_dev = NULL; ///< Pointer to I2C bus interface
+  Adafruit_TCS34725_Transport *transport();
+  uint16_t integrationDelay();
+  void updateDerived();
+  uint32_t rateScale(uint8_t atime, uint8_t gain);
+  uint32_t measureClear(uint8_t atime, tcs34725Gain_t gain, uint8_t samples);
+  void measureSum(uint8_t samples, uint32_t sum[4]);
+  void makeSample(const tcs34725Snapshot_t *snap, tcs34725Sample_t *sample);
+  tcs34725Dark_t *findDark(uint8_t atime, uint8_t gain);
+  bool busWrite(uint8_t op, const uint8_t *buffer, size_t len);
+  bool busWriteRead(uint8_t op, const uint8_t *wbuf, size_t wlen,
+                    uint8_t *rbuf, size_t rlen);
+  void restartCycle();
+  void updateRegister(uint8_t reg, uint8_t value);
+  void updateRegisters(uint8_t reg, const uint8_t *values, uint8_t len);
+  void recentreLimits(uint16_t c);
+  void beginFastCycles();
+  boolean readFastCycle(tcs34725Snapshot_t *snap, uint32_t *last,
+                        boolean first, boolean *complete);
+  void endFastCycles(const tcs34725Config_t *saved);
+
+#if defined(ARDUINO)
+  Adafruit_TCS34725_BusIO _busio; ///< Built-in I2C transport, no heap use
+#endif
+  Adafruit_TCS34725_Transport *_bus = NULL; ///< Caller's transport, or NULL
+                                            ///< to use _busio
   boolean _tcs34725Initialised;
   tcs34725Gain_t _tcs34725Gain;
   uint8_t _tcs34725IntegrationTime;
+  uint16_t _integrationDelay;     ///< Cached integrationDelay(), ms
+  uint16_t _saturation;           ///< Cached getSaturation()
+  uint16_t _saturation75;         ///< Cached getSaturation75()
+  uint32_t _luxDivisor;           ///< 384 x cycles x gain, for dn40Lux()
+  uint16_t _generation = 0;       ///< Bumped on every ATIME or gain change
+  uint8_t _generationAtime = 0;   ///< ATIME of the current generation
+  uint8_t _generationGain = 0xFF; ///< Gain of the current generation
+  uint32_t _rateScale;            ///< rateScale() for the config, 0 until used
+  float _countsPerLux;            ///< getCountsPerLux(), 0 until used
+  float _maxLux;                  ///< getMaxLux(), 0 until used
+  uint32_t _gainRatio[4] = {1024, 4096, 16384,
+                            61440}; ///< Gain multipliers, Q10
+  tcs34725Dark_t *_darkTable = NULL; ///< Caller's dark offset table
+  uint8_t _darkSize = 0;             ///< Entries in _darkTable
+  tcs34725Dark_t *_dark = NULL;      ///< Entry for the current config
+  const tcs34725Ccm_t *_ccm = NULL;  ///< Caller's colour correction matrix
+  uint32_t _transactions = 0; ///< I2C transactions issued since last reset
+#ifdef TCS34725_STATS
+  tcs34725Stats_t _stats = {}; ///< Instrumentation counters
+#endif
+  uint32_t _sampleDeadline = 0; ///< micros() at which the pending cycle ends
+  uint32_t _ponTime = 0;        ///< micros() when PON was last set
+  uint32_t _cycleEnd = 0; ///< micros() at which a known cycle ends, for
+                          ///< sample timestamps
+  boolean _measuring = false;   ///< True while a measurement is pending
+  uint32_t _awakeTime = 0; ///< Microseconds powered up by the last one-shot
+  uint8_t _shadow[TCS34725_CONTROL + 1] = {0}; ///< Copy of regs 0x00-0x0F
+  Adafruit_TCS34725_SampleQueue *_queue = NULL; ///< Interrupt mode output
+  volatile boolean _intPending = false;  ///< Set by handleInterrupt()
+  volatile uint32_t _intTimestamp = 0;   ///< micros() of the pending interrupt
+  uint16_t _missedInterrupts = 0; ///< Results overwritten before service()
+  uint8_t _deadband = 0; ///< Change detection window, % of clear; 0 = off
+  boolean _mainsKnown = false; ///< detectMains() has succeeded
+  tcs34725Mains_t _mains = TCS34725_MAINS_50HZ; ///< Cached detectMains() result
+};
+
+/** Convergence statistics for Adafruit_TCS34725_Autorange */
+typedef struct {
+  uint16_t rangeChanges; /**< Number of gain/integration time changes */
+  uint16_t lastSteps;    /**< Changes needed by the most recent convergence */
+  uint32_t lastLatency;  /**< ms from the first out-of-range reading to the
+                              next usable one, for the last convergence */
+  uint32_t maxLatency;   /**< Worst lastLatency seen */
+} tcs34725AutorangeStats_t;
+
+/*!
+ *  @brief  Picks gain and integration time from the measured clear count.
+ *          Counts scale linearly with gain x integration cycles, so a single
+ *          unsaturated reading is enough to predict the setting that puts
+ *          the clear channel at half of its usable range.
+ */
+class Adafruit_TCS34725_Autorange {
+public:
+  Adafruit_TCS34725_Autorange(Adafruit_TCS34725 *tcs,
+                              uint8_t maxIt = TCS34725_INTEGRATIONTIME_614MS);
+
+  boolean poll(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
+  boolean update(uint16_t c);
+  void getStats(tcs34725AutorangeStats_t *stats);
+
+private:
+  Adafruit_TCS34725 *_tcs;          ///< Sensor being ranged
+  uint16_t _maxCycles;              ///< Longest integration allowed, cycles
+  boolean _converging;              ///< True between a change and a good read
+  uint32_t _convergeStart;          ///< millis() of the out-of-range reading
+  tcs34725AutorangeStats_t _stats; ///< Convergence statistics
 };
 
 #endif
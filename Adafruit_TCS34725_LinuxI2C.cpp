@@ -0,0 +1,161 @@
+/*!
+ *  @file Adafruit_TCS34725_LinuxI2C.cpp
+ *
+ *  Transport for using the TCS34725 driver through the Linux i2c-dev
+ *  interface (/dev/i2c-N). Outside an Arduino build this file also provides
+ *  the driver's timing calls from CLOCK_MONOTONIC. noInterrupts() does
+ *  nothing there, so call handleInterrupt() and service() from one thread.
+ *
+ *  BSD license (see license.txt)
+ */
+#if defined(__linux__)
+
+#include "Adafruit_TCS34725_LinuxI2C.h"
+
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#if !defined(ARDUINO)
+#include <errno.h>
+#include <time.h>
+
+/*!
+ *  @brief  Reads the monotonic clock
+ *  @return Microseconds since an arbitrary point
+ */
+static uint64_t hostMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*!
+ *  @brief  Sleeps, resuming after signals
+ *  @param  us
+ *          Microseconds to sleep for
+ */
+static void hostSleep(uint64_t us) {
+  struct timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    ;
+}
+
+/*!
+ *  @brief  Milliseconds from the monotonic clock
+ *  @return Milliseconds since an arbitrary point
+ */
+unsigned long millis(void) { return hostMicros() / 1000; }
+
+/*!
+ *  @brief  Microseconds from the monotonic clock
+ *  @return Microseconds since an arbitrary point
+ */
+unsigned long micros(void) { return hostMicros(); }
+
+/*!
+ *  @brief  Blocks the calling thread
+ *  @param  ms
+ *          Milliseconds to block for
+ */
+void delay(unsigned long ms) { hostSleep((uint64_t)ms * 1000); }
+
+/*!
+ *  @brief  Blocks the calling thread
+ *  @param  us
+ *          Microseconds to block for
+ */
+void delayMicroseconds(unsigned int us) { hostSleep(us); }
+
+/*!
+ *  @brief  Does nothing: a Linux process has no interrupt handlers to hold
+ *          off
+ */
+void noInterrupts(void) {}
+
+/*!
+ *  @brief  Does nothing, see noInterrupts()
+ */
+void interrupts(void) {}
+#endif
+
+/*!
+ *  @brief  Constructor
+ *  @param  *device
+ *          Path of the i2c-dev node, e.g. "/dev/i2c-1"; must stay valid
+ *  @param  addr
+ *          7-bit I2C address
+ */
+Adafruit_TCS34725_LinuxI2C::Adafruit_TCS34725_LinuxI2C(const char *device,
+                                                       uint8_t addr)
+    : _device(device), _addr(addr), _fd(-1), _syscalls(0) {}
+
+/*!
+ *  @brief  Destructor, closes the device node
+ */
+Adafruit_TCS34725_LinuxI2C::~Adafruit_TCS34725_LinuxI2C() {
+  if (_fd >= 0)
+    close(_fd);
+}
+
+/*!
+ *  @brief  Opens the device node
+ *  @return True if the node could be opened
+ */
+bool Adafruit_TCS34725_LinuxI2C::begin() {
+  if (_fd < 0)
+    _fd = open(_device, O_RDWR);
+  return _fd >= 0;
+}
+
+/*!
+ *  @brief  Writes a buffer in one I2C_RDWR transaction
+ *  @param  *buffer
+ *          Bytes to write
+ *  @param  len
+ *          Number of bytes
+ *  @return True on success
+ */
+bool Adafruit_TCS34725_LinuxI2C::write(const uint8_t *buffer, size_t len) {
+  struct i2c_msg msg = {_addr, 0, (__u16)len, (__u8 *)buffer};
+  struct i2c_rdwr_ioctl_data data = {&msg, 1};
+
+  _syscalls++;
+  return ioctl(_fd, I2C_RDWR, &data) == 1;
+}
+
+/*!
+ *  @brief  Writes then reads with a repeated start, as two messages in one
+ *          I2C_RDWR ioctl
+ *  @param  *write_buffer
+ *          Bytes to write
+ *  @param  write_len
+ *          Number of bytes to write
+ *  @param  *read_buffer
+ *          Destination for the bytes read
+ *  @param  read_len
+ *          Number of bytes to read
+ *  @return True on success
+ */
+bool Adafruit_TCS34725_LinuxI2C::write_then_read(const uint8_t *write_buffer,
+                                                 size_t write_len,
+                                                 uint8_t *read_buffer,
+                                                 size_t read_len) {
+  struct i2c_msg msgs[2] = {
+      {_addr, 0, (__u16)write_len, (__u8 *)write_buffer},
+      {_addr, I2C_M_RD, (__u16)read_len, read_buffer}};
+  struct i2c_rdwr_ioctl_data data = {msgs, 2};
+
+  _syscalls++;
+  return ioctl(_fd, I2C_RDWR, &data) == 2;
+}
+
+/*!
+ *  @brief  Gets the number of ioctl() calls made for bus transactions
+ *  @return Syscall count
+ */
+uint32_t Adafruit_TCS34725_LinuxI2C::getSyscallCount() { return _syscalls; }
+
+#endif
@@ -0,0 +1,43 @@
+/*!
+ *  @file Adafruit_TCS34725_LinuxI2C.h
+ *
+ *  Transport for using the TCS34725 driver through the Linux i2c-dev
+ *  interface (/dev/i2c-N).
+ *
+ *  BSD license (see license.txt)
+ */
+#ifndef _TCS34725_LINUXI2C_H_
+#define _TCS34725_LINUXI2C_H_
+
+#if defined(__linux__)
+
+#include "Adafruit_TCS34725.h"
+
+/*!
+ *  @brief  Talks to the sensor through /dev/i2c-N. Every transaction,
+ *          including a combined write/read with repeated start, is a single
+ *          I2C_RDWR ioctl, so a burst read of a sample costs one syscall.
+ */
+class Adafruit_TCS34725_LinuxI2C : public Adafruit_TCS34725_Transport {
+public:
+  Adafruit_TCS34725_LinuxI2C(const char *device = "/dev/i2c-1",
+                             uint8_t addr = TCS34725_ADDRESS);
+  ~Adafruit_TCS34725_LinuxI2C();
+
+  bool begin();
+  bool write(const uint8_t *buffer, size_t len);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len);
+
+  uint32_t getSyscallCount();
+
+private:
+  const char *_device; ///< Path of the i2c-dev node
+  uint8_t _addr;       ///< 7-bit device address
+  int _fd;             ///< Open file descriptor, or -1
+  uint32_t _syscalls;  ///< ioctl() calls made for transactions
+};
+
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+/*!
+ *  @file Adafruit_TCS34725_Multi.cpp
+ *
+ *  Support for running many TCS34725 sensors, which all share the fixed
+ *  address 0x29, behind TCA9548A-style I2C multiplexers.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "Adafruit_TCS34725_Multi.h"
+
+/*!
+ *  @brief  Constructor for a single multiplexer
+ *  @param  *mux
+ *          Transport for the multiplexer's own address
+ */
+Adafruit_TCS34725_Mux::Adafruit_TCS34725_Mux(Adafruit_TCS34725_Transport *mux)
+    : _single(mux), _muxes(&_single), _count(1), _channel(0xFF),
+      _switches(0) {}
+
+/*!
+ *  @brief  Constructor for several multiplexers on the same bus
+ *  @param  **muxes
+ *          Transports for each multiplexer's address; must outlive this
+ *          object
+ *  @param  count
+ *          Number of multiplexers
+ */
+Adafruit_TCS34725_Mux::Adafruit_TCS34725_Mux(
+    Adafruit_TCS34725_Transport **muxes, uint8_t count)
+    : _single(NULL), _muxes(muxes), _count(count), _channel(0xFF),
+      _switches(0) {}
+
+/*!
+ *  @brief  Initializes the multiplexers and disconnects every channel
+ *  @return True if all multiplexers responded
+ */
+bool Adafruit_TCS34725_Mux::begin() {
+  uint8_t off = 0;
+  bool ok = true;
+
+  for (uint8_t i = 0; i < _count; i++)
+    ok = _muxes[i]->begin() && _muxes[i]->write(&off, 1) && ok;
+  _channel = 0xFF;
+  return ok;
+}
+
+/*!
+ *  @brief  Connects a channel to the upstream bus. Does nothing if it is
+ *          already the selected channel.
+ *  @param  channel
+ *          Channel number, 0-7 on the first multiplexer, 8-15 on the
+ *          second and so on
+ *  @return True on success
+ */
+bool Adafruit_TCS34725_Mux::select(uint8_t channel) {
+  if (channel == _channel)
+    return true;
+
+  uint8_t mux = channel / TCA9548A_CHANNELS;
+  if (mux >= _count)
+    return false;
+
+  /* Leaving another multiplexer: disconnect it so its sensor does not
+     answer at the same address */
+  if (_channel != 0xFF && _channel / TCA9548A_CHANNELS != mux) {
+    uint8_t off = 0;
+    _switches++;
+    if (!_muxes[_channel / TCA9548A_CHANNELS]->write(&off, 1)) {
+      _channel = 0xFF;
+      return false;
+    }
+  }
+
+  uint8_t mask = 1 << (channel % TCA9548A_CHANNELS);
+  _switches++;
+  if (!_muxes[mux]->write(&mask, 1)) {
+    _channel = 0xFF;
+    return false;
+  }
+  _channel = channel;
+  return true;
+}
+
+/*!
+ *  @brief  Gets the number of channel select writes issued
+ *  @return Switch count
+ */
+uint32_t Adafruit_TCS34725_Mux::getSwitchCount() { return _switches; }
+
+/*!
+ *  @brief  Constructor
+ *  @param  *mux
+ *          Multiplexer group the channel belongs to
+ *  @param  channel
+ *          Channel number within the group
+ *  @param  *device
+ *          Transport for the sensor address, e.g. an Adafruit_TCS34725_BusIO
+ *          for 0x29; may be shared between channels
+ */
+Adafruit_TCS34725_MuxChannel::Adafruit_TCS34725_MuxChannel(
+    Adafruit_TCS34725_Mux *mux, uint8_t channel,
+    Adafruit_TCS34725_Transport *device)
+    : _mux(mux), _channel(channel), _device(device) {}
+
+/*!
+ *  @brief  Selects the channel and checks that the sensor responds
+ *  @return True if the sensor is present
+ */
+bool Adafruit_TCS34725_MuxChannel::begin() {
+  return _mux->select(_channel) && _device->begin();
+}
+
+/*!
+ *  @brief  Selects the channel and writes a buffer
+ *  @param  *buffer
+ *          Bytes to write
+ *  @param  len
+ *          Number of bytes
+ *  @return True on success
+ */
+bool Adafruit_TCS34725_MuxChannel::write(const uint8_t *buffer, size_t len) {
+  return _mux->select(_channel) && _device->write(buffer, len);
+}
+
+/*!
+ *  @brief  Selects the channel, then writes and reads with a repeated start
+ *  @param  *write_buffer
+ *          Bytes to write
+ *  @param  write_len
+ *          Number of bytes to write
+ *  @param  *read_buffer
+ *          Destination for the bytes read
+ *  @param  read_len
+ *          Number of bytes to read
+ *  @return True on success
+ */
+bool Adafruit_TCS34725_MuxChannel::write_then_read(const uint8_t *write_buffer,
+                                                   size_t write_len,
+                                                   uint8_t *read_buffer,
+                                                   size_t read_len) {
+  return _mux->select(_channel) &&
+         _device->write_then_read(write_buffer, write_len, read_buffer,
+                                  read_len);
+}
+
+/*!
+ *  @brief  Constructor
+ *  @param  **sensors
+ *          Sensors to manage, each already started with begin() on its own
+ *          Adafruit_TCS34725_MuxChannel; the array must outlive this object
+ *  @param  count
+ *          Number of sensors
+ */
+Adafruit_TCS34725_Multi::Adafruit_TCS34725_Multi(Adafruit_TCS34725 **sensors,
+                                                 uint8_t count)
+    : _sensors(sensors), _count(count), _next(0) {}
+
+/*!
+ *  @brief  Starts a fresh integration on every sensor, in order, so that
+ *          their results become due in the same order
+ */
+void Adafruit_TCS34725_Multi::start() {
+  for (uint8_t i = 0; i < _count; i++)
+    _sensors[i]->startMeasurement();
+  _next = 0;
+}
+
+/*!
+ *  @brief  Reads the next sensor with a new result, if any. Never blocks.
+ *  @param  *r
+ *          Red value
+ *  @param  *g
+ *          Green value
+ *  @param  *b
+ *          Blue value
+ *  @param  *c
+ *          Clear channel value
+ *  @return Index of the sensor the values came from, or -1 if no sensor had
+ *          a new result
+ */
+int8_t Adafruit_TCS34725_Multi::poll(uint16_t *r, uint16_t *g, uint16_t *b,
+                                     uint16_t *c) {
+  for (uint8_t i = 0; i < _count; i++) {
+    uint8_t k = _next + i;
+    if (k >= _count)
+      k -= _count;
+    if (_sensors[k]->poll(r, g, b, c)) {
+      _next = (k + 1 < _count) ? k + 1 : 0;
+      return k;
+    }
+  }
+  return -1;
+}
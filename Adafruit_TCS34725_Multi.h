@@ -0,0 +1,86 @@
+/*!
+ *  @file Adafruit_TCS34725_Multi.h
+ *
+ *  Support for running many TCS34725 sensors, which all share the fixed
+ *  address 0x29, behind TCA9548A-style I2C multiplexers.
+ *
+ *  BSD license (see license.txt)
+ */
+#ifndef _TCS34725_MULTI_H_
+#define _TCS34725_MULTI_H_
+
+#include "Adafruit_TCS34725.h"
+
+#define TCA9548A_ADDRESS (0x70) ///< Default multiplexer address (0x70-0x77)
+#define TCA9548A_CHANNELS (8)   ///< Downstream channels per multiplexer
+
+/*!
+ *  @brief  One or more TCA9548A-style multiplexers on the same upstream bus.
+ *          Channels are numbered across all of them, 8 per multiplexer in
+ *          the order given. The selected channel is remembered so that
+ *          repeated access to the same sensor costs no extra transaction,
+ *          and a multiplexer is only switched off when a channel on a
+ *          different one is needed.
+ */
+class Adafruit_TCS34725_Mux {
+public:
+  Adafruit_TCS34725_Mux(Adafruit_TCS34725_Transport *mux);
+  Adafruit_TCS34725_Mux(Adafruit_TCS34725_Transport **muxes, uint8_t count);
+
+  bool begin();
+  bool select(uint8_t channel);
+  uint32_t getSwitchCount();
+
+private:
+  Adafruit_TCS34725_Transport *_single;  ///< Storage for the one-mux case
+  Adafruit_TCS34725_Transport **_muxes;  ///< Multiplexer control transports
+  uint8_t _count;                        ///< Number of multiplexers
+  uint8_t _channel;                      ///< Selected channel, or 0xFF
+  uint32_t _switches;                    ///< Channel select writes issued
+};
+
+/*!
+ *  @brief  Transport for a sensor on one multiplexer channel. Selects the
+ *          channel, if needed, then forwards to the transport for the
+ *          sensor's address, which may be shared by all channels.
+ */
+class Adafruit_TCS34725_MuxChannel : public Adafruit_TCS34725_Transport {
+public:
+  Adafruit_TCS34725_MuxChannel(Adafruit_TCS34725_Mux *mux, uint8_t channel,
+                               Adafruit_TCS34725_Transport *device);
+
+  bool begin();
+  bool write(const uint8_t *buffer, size_t len);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len);
+
+private:
+  Adafruit_TCS34725_Mux *_mux;          ///< Multiplexer group
+  uint8_t _channel;                     ///< Channel the sensor is on
+  Adafruit_TCS34725_Transport *_device; ///< Transport for address 0x29
+};
+
+/*!
+ *  @brief  Pipelines measurements across several sensors. start() sets
+ *          every sensor integrating; poll() then visits them round robin,
+ *          starting after the last one read, and burst-reads the first
+ *          whose result is due. Sensors whose integration has not finished
+ *          are skipped without any bus traffic, so each result costs one
+ *          read and, since the sensors finish in the order they were
+ *          started, one channel switch. With N sensors the aggregate rate
+ *          approaches N times that of a single sensor.
+ */
+class Adafruit_TCS34725_Multi {
+public:
+  Adafruit_TCS34725_Multi(Adafruit_TCS34725 **sensors, uint8_t count);
+
+  void start();
+  int8_t poll(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c);
+
+private:
+  Adafruit_TCS34725 **_sensors; ///< Caller-provided sensor array
+  uint8_t _count;               ///< Number of sensors
+  uint8_t _next;                ///< Sensor to visit first on the next poll()
+};
+
+#endif
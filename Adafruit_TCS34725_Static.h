@@ -0,0 +1,206 @@
+/*!
+ *  @file Adafruit_TCS34725_Static.h
+ *
+ *  TCS34725 driver specialised at compile time for one integration time and
+ *  gain.
+ *
+ *  BSD license (see license.txt)
+ */
+#ifndef _TCS34725_STATIC_H_
+#define _TCS34725_STATIC_H_
+
+#include "Adafruit_TCS34725.h"
+
+/*!
+ *  @brief  TCS34725 driver for an integration time and gain fixed at compile
+ *          time. The integration delay, saturation levels and counts-per-lux
+ *          are constant expressions, so getRawData() and the DN40
+ *          conversions have no runtime dependence on the configuration and
+ *          need no floating point. begin() must be called before reading.
+ *          The base class is private and only the calls that cannot change
+ *          ATIME or the gain are re-exported, so the setting cannot be
+ *          altered through a base class reference, the autorange engine,
+ *          calibrateGains() or the flicker-free read either. The DN40
+ *          conversions use the nominal gain, so measured gain ratios are
+ *          not supported and setGainRatios() is not re-exported.
+ *  @tparam IT
+ *          Integration time (TCS34725_INTEGRATIONTIME_*)
+ *  @tparam GAIN
+ *          Gain
+ */
+template <uint8_t IT, tcs34725Gain_t GAIN>
+class Adafruit_TCS34725_Static : private Adafruit_TCS34725 {
+public:
+  /*!
+   *  @brief  Constructor
+   */
+  Adafruit_TCS34725_Static() : Adafruit_TCS34725(IT, GAIN) {}
+
+  using Adafruit_TCS34725::begin;
+  using Adafruit_TCS34725::init;
+  using Adafruit_TCS34725::getIntegrationTime;
+  using Adafruit_TCS34725::getGain;
+  using Adafruit_TCS34725::getSaturation;
+  using Adafruit_TCS34725::getSaturation75;
+  using Adafruit_TCS34725::getConfig;
+  using Adafruit_TCS34725::getSnapshot;
+  using Adafruit_TCS34725::getSample;
+  using Adafruit_TCS34725::getConfigGeneration;
+  using Adafruit_TCS34725::normalizeSample;
+  using Adafruit_TCS34725::getNormalizedSample;
+  using Adafruit_TCS34725::setDarkTable;
+  using Adafruit_TCS34725::captureDark;
+  using Adafruit_TCS34725::subtractDark;
+  using Adafruit_TCS34725::setColorCorrection;
+  using Adafruit_TCS34725::correctColor;
+  using Adafruit_TCS34725::getRGB;
+  using Adafruit_TCS34725::startMeasurement;
+  using Adafruit_TCS34725::sampleReady;
+  using Adafruit_TCS34725::poll;
+  using Adafruit_TCS34725::getRawDataOneShot;
+  using Adafruit_TCS34725::getAwakeTime;
+  using Adafruit_TCS34725::setSamplePeriod;
+  using Adafruit_TCS34725::getSamplePeriod;
+  using Adafruit_TCS34725::getSampleRate;
+  using Adafruit_TCS34725::getAverageCurrent;
+  using Adafruit_TCS34725::calculateColorTemperature;
+  using Adafruit_TCS34725::calculateColorTemperature_fixed;
+  using Adafruit_TCS34725::calculateLux;
+  using Adafruit_TCS34725::read8;
+  using Adafruit_TCS34725::read16;
+  using Adafruit_TCS34725::readBlock;
+  using Adafruit_TCS34725::getTransactionCount;
+  using Adafruit_TCS34725::resetTransactionCount;
+#ifdef TCS34725_STATS
+  using Adafruit_TCS34725::getStats;
+  using Adafruit_TCS34725::resetStats;
+#endif
+  using Adafruit_TCS34725::setInterrupt;
+  using Adafruit_TCS34725::clearInterrupt;
+  using Adafruit_TCS34725::beginInterrupts;
+  using Adafruit_TCS34725::beginChangeDetection;
+  using Adafruit_TCS34725::handleInterrupt;
+  using Adafruit_TCS34725::service;
+  using Adafruit_TCS34725::getMissedInterrupts;
+  using Adafruit_TCS34725::setIntLimits;
+  using Adafruit_TCS34725::enable;
+  using Adafruit_TCS34725::disable;
+
+  /*!
+   *  @brief  Gets the number of 2.4ms integration cycles
+   *  @return Cycles
+   */
+  static constexpr uint16_t cycles() { return 256 - IT; }
+
+  /*!
+   *  @brief  Gets the gain as a multiplier
+   *  @return 1, 4, 16 or 60
+   */
+  static constexpr uint8_t gainFactor() {
+    return (GAIN == TCS34725_GAIN_1X)    ? 1
+           : (GAIN == TCS34725_GAIN_4X)  ? 4
+           : (GAIN == TCS34725_GAIN_16X) ? 16
+                                         : 60;
+  }
+
+  /*!
+   *  @brief  Gets the time needed to complete one integration cycle
+   *  @return Integration time in milliseconds, rounded up
+   */
+  static constexpr uint16_t delayMs() { return cycles() * 12 / 5 + 1; }
+
+  /*!
+   *  @brief  Gets the clear count at which the ADC saturates: analog
+   *          saturation up to 153.6ms, digital saturation beyond it
+   *  @return Saturation level
+   */
+  static constexpr uint16_t saturation() {
+    return (cycles() > 63) ? 65535 : 1024 * cycles();
+  }
+
+  /*!
+   *  @brief  Gets the saturation level allowing for ripple, which is 75% of
+   *          saturation() for integration times up to 153.6ms
+   *  @return Ripple-adjusted saturation level
+   */
+  static constexpr uint16_t saturation75() {
+    return (cycles() > 63) ? 65535 : 768 * cycles();
+  }
+
+  /*!
+   *  @brief  Gets the DN40 counts per lux, 2.4ms x cycles x gain / 310
+   *  @return Counts per lux
+   */
+  static constexpr float countsPerLux() {
+    return 2.4F * cycles() * gainFactor() / 310.0F;
+  }
+
+  /*!
+   *  @brief  Reads the raw channel values in one burst and waits for the
+   *          next integration to complete
+   *  @param  *r
+   *          Red value
+   *  @param  *g
+   *          Green value
+   *  @param  *b
+   *          Blue value
+   *  @param  *c
+   *          Clear channel value
+   */
+  void getRawData(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c) {
+    uint8_t buffer[8];
+    readBlock(TCS34725_CDATAL, buffer, 8);
+
+    *c = (uint16_t(buffer[1]) << 8) | buffer[0];
+    *r = (uint16_t(buffer[3]) << 8) | buffer[2];
+    *g = (uint16_t(buffer[5]) << 8) | buffer[4];
+    *b = (uint16_t(buffer[7]) << 8) | buffer[6];
+
+    wait(delayMs());
+  }
+
+  /*!
+   *  @brief  Checks a clear channel value against saturation75()
+   *  @param  c
+   *          Clear channel value
+   *  @return True if the reading should be discarded
+   */
+  static boolean isSaturated(uint16_t c) { return c >= saturation75(); }
+
+  /*!
+   *  @brief  Converts raw values to lux with the integer DN40 algorithm
+   *  @param  r
+   *          Red value
+   *  @param  g
+   *          Green value
+   *  @param  b
+   *          Blue value
+   *  @param  c
+   *          Clear channel value
+   *  @return Lux value
+   */
+  static uint16_t calculateLux_dn40(uint16_t r, uint16_t g, uint16_t b,
+                                    uint16_t c) {
+    return dn40Lux(r, g, b, c, 384UL * cycles() * gainFactor());
+  }
+
+  /*!
+   *  @brief  Converts raw values to colour temperature with the DN40
+   *          algorithm
+   *  @param  r
+   *          Red value
+   *  @param  g
+   *          Green value
+   *  @param  b
+   *          Blue value
+   *  @param  c
+   *          Clear channel value
+   *  @return Color temperature in degrees Kelvin, or 0 if saturated
+   */
+  static uint16_t calculateColorTemperature_dn40(uint16_t r, uint16_t g,
+                                                 uint16_t b, uint16_t c) {
+    return dn40ColorTemperature(r, g, b, c, saturation75());
+  }
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include <Wire.h>
+#include "Adafruit_TCS34725.h"
+
+/* Compares the float and integer-only colour temperature and lux
+   calculations. No sensor is needed: the calculations only use the gain and
+   integration time stored in the object. */
+
+Adafruit_TCS34725 tcs = Adafruit_TCS34725(TCS34725_INTEGRATIONTIME_154MS, TCS34725_GAIN_4X);
+
+#define ITERATIONS 1000
+
+// DN40 lux in float, as in the tcs34725autorange example
+float luxFloat(uint16_t r, uint16_t g, uint16_t b, uint16_t c) {
+  float ir = (r + g + b > c) ? (r + g + b - c) / 2 : 0;
+  float cpl = (2.4F * (256 - TCS34725_INTEGRATIONTIME_154MS) * 4) / 310.0F;
+  return (0.136F * (r - ir) + 1.000F * (g - ir) - 0.444F * (b - ir)) / cpl;
+}
+
+void setup(void) {
+  Serial.begin(115200);
+  while (!Serial)
+    delay(10);
+
+  volatile uint32_t sink = 0;
+  uint16_t r = 4200, g = 3900, b = 2800, c = 10500;
+  unsigned long t;
+
+  t = micros();
+  for (int i = 0; i < ITERATIONS; i++)
+    sink += tcs.calculateColorTemperature(r + i, g, b);
+  t = micros() - t;
+  Serial.print("McCamy CCT, float: "); Serial.print((float)t / ITERATIONS); Serial.println(" us");
+
+  t = micros();
+  for (int i = 0; i < ITERATIONS; i++)
+    sink += tcs.calculateColorTemperature_fixed(r + i, g, b);
+  t = micros() - t;
+  Serial.print("McCamy CCT, fixed: "); Serial.print((float)t / ITERATIONS); Serial.println(" us");
+
+  t = micros();
+  for (int i = 0; i < ITERATIONS; i++)
+    sink += luxFloat(r + i, g, b, c);
+  t = micros() - t;
+  Serial.print("DN40 lux, float:   "); Serial.print((float)t / ITERATIONS); Serial.println(" us");
+
+  t = micros();
+  for (int i = 0; i < ITERATIONS; i++)
+    sink += tcs.calculateLux_dn40(r + i, g, b, c);
+  t = micros() - t;
+  Serial.print("DN40 lux, fixed:   "); Serial.print((float)t / ITERATIONS); Serial.println(" us");
+
+  t = micros();
+  for (int i = 0; i < ITERATIONS; i++)
+    sink += tcs.calculateColorTemperature_dn40(r + i, g, b, c);
+  t = micros() - t;
+  Serial.print("DN40 CCT (integer): "); Serial.print((float)t / ITERATIONS); Serial.println(" us");
+
+  Serial.print("Results: ");
+  Serial.print(tcs.calculateColorTemperature(r, g, b)); Serial.print(" K / ");
+  Serial.print(tcs.calculateColorTemperature_fixed(r, g, b)); Serial.print(" K, ");
+  Serial.print(luxFloat(r, g, b, c)); Serial.print(" lux / ");
+  Serial.print(tcs.calculateLux_dn40(r, g, b, c)); Serial.println(" lux");
+}
+
+void loop(void) {}
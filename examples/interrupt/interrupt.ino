@@ -5,24 +5,16 @@
 /* Initialise with specific int time and gain values */
 Adafruit_TCS34725 tcs = Adafruit_TCS34725(TCS34725_INTEGRATIONTIME_614MS, TCS34725_GAIN_1X);
 const int interruptPin = 2;
-volatile boolean state = false;
+
+/* Samples are queued by tcs.service() and consumed in loop() */
+tcs34725Sample_t sampleBuffer[8];
+Adafruit_TCS34725_SampleQueue samples(sampleBuffer, 8);
 
 
 //Interrupt Service Routine
 void isr() 
 {
-  state = true;
-}
-
-
-/* tcs.getRawData() does a delay(Integration_Time) after the sensor readout.
-We don't need to wait for the next integration cycle because we receive an interrupt when the integration cycle is complete*/
-void getRawData_noDelay(uint16_t *r, uint16_t *g, uint16_t *b, uint16_t *c)
-{
-  *c = tcs.read16(TCS34725_CDATAL);
-  *r = tcs.read16(TCS34725_RDATAL);
-  *g = tcs.read16(TCS34725_GDATAL);
-  *b = tcs.read16(TCS34725_BDATAL);
+  tcs.handleInterrupt();
 }
 
 
@@ -39,31 +31,32 @@ void setup() {
     while (1);
   }
   
-  // Set persistence filter to generate an interrupt for every RGB Cycle, regardless of the integration limits
-  tcs.write8(TCS34725_PERS, TCS34725_PERS_NONE); 
-  tcs.setInterrupt(true);
+  // Generate an interrupt for every RGB Cycle, regardless of the integration limits
+  tcs.beginInterrupts(&samples, TCS34725_PERS_NONE);
   
   Serial.flush();
 }
 
 
 void loop() {
-  if (state) {
-    uint16_t r, g, b, c, colorTemp, lux;
-    getRawData_noDelay(&r, &g, &b, &c);
-    colorTemp = tcs.calculateColorTemperature(r, g, b);
-    lux = tcs.calculateLux(r, g, b);
+  // Burst-reads the data and clears the interrupt; no delay() involved.
+  // Must run at least once per integration cycle, or results are
+  // overwritten; tcs.getMissedInterrupts() counts them
+  tcs.service();
+
+  tcs34725Sample_t s;
+  while (samples.pop(&s)) {
+    uint16_t colorTemp = tcs.calculateColorTemperature(s.r, s.g, s.b);
+    uint16_t lux = tcs.calculateLux(s.r, s.g, s.b);
     
+    Serial.print("t: "); Serial.print(s.timestamp); Serial.print(" ms - ");
     Serial.print("Color Temp: "); Serial.print(colorTemp, DEC); Serial.print(" K - ");
     Serial.print("Lux: "); Serial.print(lux, DEC); Serial.print(" - ");
-    Serial.print("R: "); Serial.print(r, DEC); Serial.print(" ");
-    Serial.print("G: "); Serial.print(g, DEC); Serial.print(" ");
-    Serial.print("B: "); Serial.print(b, DEC); Serial.print(" ");
-    Serial.print("C: "); Serial.print(c, DEC); Serial.print(" ");
+    Serial.print("R: "); Serial.print(s.r, DEC); Serial.print(" ");
+    Serial.print("G: "); Serial.print(s.g, DEC); Serial.print(" ");
+    Serial.print("B: "); Serial.print(s.b, DEC); Serial.print(" ");
+    Serial.print("C: "); Serial.print(s.c, DEC); Serial.print(" ");
     Serial.println(" ");
     Serial.flush();
-
-    tcs.clearInterrupt();
-    state = false;
   }
 }
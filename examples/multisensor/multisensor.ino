@@ -0,0 +1,65 @@
+#include <Wire.h>
+#include "Adafruit_TCS34725.h"
+#include "Adafruit_TCS34725_Multi.h"
+
+/* Example code for the Adafruit TCS34725 breakout library */
+
+/* Runs eight sensors behind a TCA9548A multiplexer. All sensors integrate
+   at the same time and are read as each result becomes due, so the total
+   sample rate is close to eight times that of a single sensor */
+
+/* Connect the multiplexer SCL/SDA to the board's I2C pins and one sensor
+   to each of its channels SC0/SD0 .. SC7/SD7 */
+
+#define SENSORS 8
+
+Adafruit_TCS34725_BusIO muxBus(TCA9548A_ADDRESS, &Wire);
+Adafruit_TCS34725_BusIO sensorBus(TCS34725_ADDRESS, &Wire);
+Adafruit_TCS34725_Mux mux(&muxBus);
+
+Adafruit_TCS34725_MuxChannel channels[SENSORS] = {
+    Adafruit_TCS34725_MuxChannel(&mux, 0, &sensorBus),
+    Adafruit_TCS34725_MuxChannel(&mux, 1, &sensorBus),
+    Adafruit_TCS34725_MuxChannel(&mux, 2, &sensorBus),
+    Adafruit_TCS34725_MuxChannel(&mux, 3, &sensorBus),
+    Adafruit_TCS34725_MuxChannel(&mux, 4, &sensorBus),
+    Adafruit_TCS34725_MuxChannel(&mux, 5, &sensorBus),
+    Adafruit_TCS34725_MuxChannel(&mux, 6, &sensorBus),
+    Adafruit_TCS34725_MuxChannel(&mux, 7, &sensorBus)};
+
+Adafruit_TCS34725 sensors[SENSORS];
+Adafruit_TCS34725 *sensorList[SENSORS];
+Adafruit_TCS34725_Multi multi(sensorList, SENSORS);
+
+void setup(void) {
+  Serial.begin(115200);
+
+  if (!mux.begin()) {
+    Serial.println("No multiplexer found ... check your connections");
+    while (1);
+  }
+
+  for (uint8_t i = 0; i < SENSORS; i++) {
+    sensorList[i] = &sensors[i];
+    if (!sensors[i].begin(&channels[i])) {
+      Serial.print("No TCS34725 found on channel "); Serial.println(i);
+      while (1);
+    }
+    sensors[i].setIntegrationTime(TCS34725_INTEGRATIONTIME_24MS);
+  }
+
+  multi.start();
+}
+
+void loop(void) {
+  uint16_t r, g, b, c;
+  int8_t sensor = multi.poll(&r, &g, &b, &c);
+
+  if (sensor >= 0) {
+    Serial.print("Sensor "); Serial.print(sensor); Serial.print(" ");
+    Serial.print("R: "); Serial.print(r, DEC); Serial.print(" ");
+    Serial.print("G: "); Serial.print(g, DEC); Serial.print(" ");
+    Serial.print("B: "); Serial.print(b, DEC); Serial.print(" ");
+    Serial.print("C: "); Serial.println(c, DEC);
+  }
+}
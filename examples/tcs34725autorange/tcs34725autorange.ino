@@ -37,17 +37,9 @@
 // Autorange class for TCS34725
 class tcs34725 {
 private:
-  struct tcs_agc {
-    tcs34725Gain_t ag;
-    uint8_t at;
-    uint16_t mincnt;
-    uint16_t maxcnt;
-  };
-  static const tcs_agc agc_lst[];
-  uint16_t agc_cur;
-
   void setGainTime(void);
   Adafruit_TCS34725 tcs;
+  Adafruit_TCS34725_Autorange agc;
 
 public:
   tcs34725(void);
@@ -64,37 +56,27 @@ public:
   float cratio, cpl, ct, lux, maxlux;
 };
 //
-// Gain/time combinations to use and the min/max limits for hysteresis
-// that avoid saturation. They should be in order from dim to bright.
-//
-// Also set the first min count and the last max count to 0 to indicate
-// the start and end of the list.
+// The library's autorange engine predicts the gain/time combination from a
+// single reading, limited here to integration times of at most 614ms.
 //
-const tcs34725::tcs_agc tcs34725::agc_lst[] = {
-  { TCS34725_GAIN_60X, TCS34725_INTEGRATIONTIME_614MS,     0, 20000 },
-  { TCS34725_GAIN_60X, TCS34725_INTEGRATIONTIME_154MS,  4990, 63000 },
-  { TCS34725_GAIN_16X, TCS34725_INTEGRATIONTIME_154MS, 16790, 63000 },
-  { TCS34725_GAIN_4X,  TCS34725_INTEGRATIONTIME_154MS, 15740, 63000 },
-  { TCS34725_GAIN_1X,  TCS34725_INTEGRATIONTIME_154MS, 15740, 0 }
-};
-tcs34725::tcs34725() : agc_cur(0), isAvailable(0), isSaturated(0) {
+tcs34725::tcs34725()
+    : tcs(TCS34725_INTEGRATIONTIME_614MS, TCS34725_GAIN_60X),
+      agc(&tcs, TCS34725_INTEGRATIONTIME_614MS), isAvailable(0),
+      isSaturated(0) {
 }
 
 // initialize the sensor
 boolean tcs34725::begin(void) {
-  tcs = Adafruit_TCS34725(agc_lst[agc_cur].at, agc_lst[agc_cur].ag);
   if ((isAvailable = tcs.begin()))
     setGainTime();
   return(isAvailable);
 }
 
-// Set the gain and integration time
+// Read back the gain and integration time chosen by the engine
 void tcs34725::setGainTime(void) {
-  tcs.setGain(agc_lst[agc_cur].ag);
-  tcs.setIntegrationTime(agc_lst[agc_cur].at);
-  atime = int(agc_lst[agc_cur].at);
+  atime = int(tcs.getIntegrationTime());
   atime_ms = ((256 - atime) * 2.4);
-  switch(agc_lst[agc_cur].ag) {
+  switch(tcs.getGain()) {
   case TCS34725_GAIN_1X:
     againx = 1;
     break;
@@ -112,20 +94,11 @@ void tcs34725::setGainTime(void) {
 
 // Retrieve data from the sensor and do the calculations
 void tcs34725::getData(void) {
-  // read the sensor and autorange if necessary
-  tcs.getRawData(&r, &g, &b, &c);
-  while(1) {
-    if (agc_lst[agc_cur].maxcnt && c > agc_lst[agc_cur].maxcnt)
-      agc_cur++;
-    else if (agc_lst[agc_cur].mincnt && c < agc_lst[agc_cur].mincnt)
-      agc_cur--;
-    else break;
-
-    setGainTime();
-    delay((256 - atime) * 2.4 * 2); // shock absorber
-    tcs.getRawData(&r, &g, &b, &c);
-    break;
-  }
+  // read the sensor, the engine discards readings that trigger a range
+  // change and restarts the integration at the new setting
+  while (!agc.poll(&r, &g, &b, &c))
+    ;
+  setGainTime();
 
   // DN40 calculations
   ir = (r + g + b > c) ? (r + g + b - c) / 2 : 0;
@@ -135,11 +108,13 @@ void tcs34725::getData(void) {
   c_comp = c - ir;
   cratio = float(ir) / float(c);
 
-  saturation = ((256 - atime) > 63) ? 65535 : 1024 * (256 - atime);
-  saturation75 = (atime_ms < 150) ? (saturation - saturation / 4) : saturation;
+  // derived constants are kept up to date by the library whenever the
+  // gain or integration time changes
+  saturation = tcs.getSaturation();
+  saturation75 = tcs.getSaturation75();
   isSaturated = (atime_ms < 150 && c > saturation75) ? 1 : 0;
-  cpl = (atime_ms * againx) / (TCS34725_GA * TCS34725_DF);
-  maxlux = 65535 / (cpl * 3);
+  cpl = tcs.getCountsPerLux();
+  maxlux = tcs.getMaxLux();
 
   lux = (TCS34725_R_Coef * float(r_comp) + TCS34725_G_Coef * float(g_comp) + TCS34725_B_Coef * float(b_comp)) / cpl;
   ct = TCS34725_CT_Coef * float(b_comp) / float(r_comp) + TCS34725_CT_Offset;
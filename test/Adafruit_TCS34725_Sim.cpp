@@ -0,0 +1,496 @@
+/*!
+ *  @file Adafruit_TCS34725_Sim.cpp
+ *
+ *  In-memory model of a TCS34725 for exercising the driver without
+ *  hardware.
+ *
+ *  BSD license (see license.txt)
+ */
+#include <math.h>
+
+#include "Adafruit_TCS34725_Sim.h"
+
+/* Nominal gain multiplier for each AGAIN setting */
+static const uint8_t simGainFactor[4] = {1, 4, 16, 60};
+
+/* Out-of-threshold cycles required for each PERS setting */
+static const uint8_t simPersistence[16] = {0,  1,  2,  3,  5,  10, 15, 20,
+                                           25, 30, 35, 40, 45, 50, 55, 60};
+
+/*!
+ *  @brief  Constructor. The device starts powered down, with the register
+ *          defaults from the datasheet and no light.
+ */
+Adafruit_TCS34725_Sim::Adafruit_TCS34725_Sim()
+    : _ptr(0), _autoInc(false), _present(true), _running(false), _now(0),
+      _cycleEnd(0), _persistCount(0), _busTime(0), _transactions(0),
+      _bytes(0), _cycles(0), _rippleHz(0), _rippleDepth(0) {
+  memset(_regs, 0, sizeof(_regs));
+  _regs[TCS34725_ATIME] = 0xFF;
+  _regs[TCS34725_WTIME] = 0xFF;
+  _regs[TCS34725_ID] = 0x44;
+  memset(_light, 0, sizeof(_light));
+  for (uint8_t i = 0; i < 4; i++)
+    _gain[i] = simGainFactor[i];
+}
+
+/*!
+ *  @brief  Checks that the simulated device is present
+ *  @return True unless disabled with setPresent()
+ */
+bool Adafruit_TCS34725_Sim::begin() { return _present; }
+
+/*!
+ *  @brief  Handles a write transaction: a command byte followed by data
+ *  @param  *buffer
+ *          Bytes written
+ *  @param  len
+ *          Number of bytes
+ *  @return False (NACK) if the device is absent or the command is invalid
+ */
+bool Adafruit_TCS34725_Sim::write(const uint8_t *buffer, size_t len) {
+  if (!_present || len == 0 || !(buffer[0] & TCS34725_COMMAND_BIT))
+    return false;
+
+  _transactions++;
+  _bytes += len;
+  command(buffer[0]);
+  for (size_t i = 1; i < len; i++) {
+    writeRegister(_ptr, buffer[i]);
+    if (_autoInc)
+      _ptr++;
+  }
+  spendBusTime(len);
+  return true;
+}
+
+/*!
+ *  @brief  Handles a combined write/read transaction. All bytes are taken
+ *          from the same instant, as a single burst read is on the real
+ *          part. The address advances on every byte read, which is how
+ *          read16() has always behaved on hardware.
+ *  @param  *write_buffer
+ *          Bytes written, starting with the command byte
+ *  @param  write_len
+ *          Number of bytes to write
+ *  @param  *read_buffer
+ *          Destination for the bytes read
+ *  @param  read_len
+ *          Number of bytes to read
+ *  @return False (NACK) if the device is absent or the command is invalid
+ */
+bool Adafruit_TCS34725_Sim::write_then_read(const uint8_t *write_buffer,
+                                            size_t write_len,
+                                            uint8_t *read_buffer,
+                                            size_t read_len) {
+  if (!write(write_buffer, write_len))
+    return false;
+
+  _bytes += read_len;
+  for (size_t i = 0; i < read_len; i++) {
+    read_buffer[i] = (_ptr < sizeof(_regs)) ? _regs[_ptr] : 0;
+    _ptr++;
+  }
+  spendBusTime(read_len);
+  return true;
+}
+
+/*!
+ *  @brief  Moves virtual time forward, completing any integration cycles
+ *          that end in the interval
+ *  @param  us
+ *          Microseconds to advance
+ */
+void Adafruit_TCS34725_Sim::advance(uint32_t us) {
+  uint32_t target = _now + us;
+  while (_running && (int32_t)(target - _cycleEnd) >= 0) {
+    _now = _cycleEnd;
+    completeCycle();
+  }
+  _now = target;
+}
+
+/*!
+ *  @brief  Gets the virtual time
+ *  @return Microseconds since construction
+ */
+uint32_t Adafruit_TCS34725_Sim::getMicros() { return _now; }
+
+/*!
+ *  @brief  Gets the virtual time
+ *  @return Milliseconds since construction
+ */
+uint32_t Adafruit_TCS34725_Sim::getMillis() { return _now / 1000; }
+
+/*!
+ *  @brief  Sets the light reaching each photodiode
+ *  @param  r
+ *          Red counts per 2.4ms cycle at 1x gain
+ *  @param  g
+ *          Green counts per 2.4ms cycle at 1x gain
+ *  @param  b
+ *          Blue counts per 2.4ms cycle at 1x gain
+ *  @param  c
+ *          Clear counts per 2.4ms cycle at 1x gain
+ */
+void Adafruit_TCS34725_Sim::setLight(float r, float g, float b, float c) {
+  _light[0] = c;
+  _light[1] = r;
+  _light[2] = g;
+  _light[3] = b;
+}
+
+/*!
+ *  @brief  Modulates the light with a sinusoidal ripple, as a lamp on AC
+ *          mains produces at twice the mains frequency. Each cycle
+ *          integrates the ripple exactly over its own start and end times.
+ *  @param  hz
+ *          Ripple frequency, e.g. 100 for 50Hz mains; 0 for steady light
+ *  @param  depth
+ *          Peak amplitude as a fraction of the setLight() level
+ */
+void Adafruit_TCS34725_Sim::setRipple(float hz, float depth) {
+  _rippleHz = hz;
+  _rippleDepth = depth;
+}
+
+/*!
+ *  @brief  Sets the actual gain of each AGAIN setting, to model a part whose
+ *          gains are off nominal. The default is exactly 1, 4, 16 and 60.
+ *  @param  gains
+ *          Multiplier for 1x, 4x, 16x and 60x
+ */
+void Adafruit_TCS34725_Sim::setGainFactors(const float gains[4]) {
+  memcpy(_gain, gains, sizeof(_gain));
+}
+
+/*!
+ *  @brief  Makes each byte on the bus cost virtual time, so multi-transaction
+ *          reads can straddle the end of an integration cycle
+ *  @param  usPerByte
+ *          Microseconds per byte (about 90 at 100kHz, 23 at 400kHz)
+ */
+void Adafruit_TCS34725_Sim::setBusTime(uint16_t usPerByte) {
+  _busTime = usPerByte;
+}
+
+/*!
+ *  @brief  Connects or disconnects the device; while absent every
+ *          transaction is NACKed
+ *  @param  present
+ *          True to respond on the bus
+ */
+void Adafruit_TCS34725_Sim::setPresent(bool present) { _present = present; }
+
+/*!
+ *  @brief  Gets the state of the INT pin
+ *  @return True while the (active low) INT output is asserted
+ */
+bool Adafruit_TCS34725_Sim::interruptAsserted() {
+  return (_regs[TCS34725_STATUS] & TCS34725_STATUS_AINT) &&
+         (_regs[TCS34725_ENABLE] & TCS34725_ENABLE_AIEN);
+}
+
+/*!
+ *  @brief  Reads a register without generating bus traffic
+ *  @param  reg
+ *          Register address
+ *  @return Register contents
+ */
+uint8_t Adafruit_TCS34725_Sim::peek(uint8_t reg) {
+  return (reg < sizeof(_regs)) ? _regs[reg] : 0;
+}
+
+/*!
+ *  @brief  Gets the number of acknowledged bus transactions
+ *  @return Transaction count
+ */
+uint32_t Adafruit_TCS34725_Sim::getTransactionCount() { return _transactions; }
+
+/*!
+ *  @brief  Gets the number of bytes transferred, command bytes included
+ *  @return Byte count
+ */
+uint32_t Adafruit_TCS34725_Sim::getByteCount() { return _bytes; }
+
+/*!
+ *  @brief  Gets the number of completed integration cycles
+ *  @return Cycle count
+ */
+uint32_t Adafruit_TCS34725_Sim::getCycleCount() { return _cycles; }
+
+/*!
+ *  @brief  Decodes a command byte
+ *  @param  cmd
+ *          Command byte, with TCS34725_COMMAND_BIT set
+ */
+void Adafruit_TCS34725_Sim::command(uint8_t cmd) {
+  uint8_t type = cmd & 0x60;
+  if (type == 0x60) {
+    /* Special function; 0x06 clears the RGBC interrupt */
+    if ((cmd & 0x1F) == 0x06)
+      _regs[TCS34725_STATUS] &= ~TCS34725_STATUS_AINT;
+    return;
+  }
+  _ptr = cmd & 0x1F;
+  _autoInc = (type == TCS34725_COMMAND_AUTOINC);
+}
+
+/*!
+ *  @brief  Stores a register write and updates the state machine
+ *  @param  reg
+ *          Register address
+ *  @param  value
+ *          Value written
+ */
+void Adafruit_TCS34725_Sim::writeRegister(uint8_t reg, uint8_t value) {
+  /* STATUS, ID and the data registers are read-only */
+  if (reg > TCS34725_CONTROL)
+    return;
+
+  uint8_t old = _regs[reg];
+  _regs[reg] = value;
+  if (reg != TCS34725_ENABLE)
+    return;
+
+  bool run = (value & TCS34725_ENABLE_PON) && (value & TCS34725_ENABLE_AEN);
+  if (run && !_running) {
+    /* The oscillator needs 2.4ms to start after PON */
+    uint32_t warmup = (old & TCS34725_ENABLE_PON) ? 0 : 2400;
+    _cycleEnd = _now + warmup + integrationTime();
+    _persistCount = 0;
+  }
+  if (!run)
+    _regs[TCS34725_STATUS] &= ~TCS34725_STATUS_AVALID;
+  _running = run;
+}
+
+/*!
+ *  @brief  Latches the result of the integration cycle that ends now and
+ *          schedules the next one
+ */
+void Adafruit_TCS34725_Sim::completeCycle() {
+  uint32_t cycles = 256 - _regs[TCS34725_ATIME];
+  float gain = _gain[_regs[TCS34725_CONTROL] & 0x03];
+  float max = (cycles > 63) ? 65535.0F : 1024.0F * cycles;
+
+  /* Light integrated over the cycle, in units of 2.4ms at the setLight()
+     level: the integral of 1 + depth sin(wt) from start to now */
+  double exposure = cycles;
+  if (_rippleHz > 0) {
+    double w = 2 * M_PI * _rippleHz / 1e6;
+    uint32_t start = _now - integrationTime();
+    exposure += _rippleDepth * (cos(w * start) - cos(w * _now)) / w / 2400;
+  }
+
+  uint16_t counts[4];
+  for (uint8_t i = 0; i < 4; i++) {
+    float v = _light[i] * gain * exposure;
+    counts[i] = (v >= max) ? (uint16_t)max : (v <= 0 ? 0 : (uint16_t)v);
+    _regs[TCS34725_CDATAL + 2 * i] = counts[i] & 0xFF;
+    _regs[TCS34725_CDATAH + 2 * i] = counts[i] >> 8;
+  }
+  _regs[TCS34725_STATUS] |= TCS34725_STATUS_AVALID;
+  _cycles++;
+
+  /* Clear channel interrupt with persistence filter */
+  uint16_t low = (uint16_t(_regs[TCS34725_AILTH]) << 8) | _regs[TCS34725_AILTL];
+  uint16_t high =
+      (uint16_t(_regs[TCS34725_AIHTH]) << 8) | _regs[TCS34725_AIHTL];
+  uint8_t required = simPersistence[_regs[TCS34725_PERS] & 0x0F];
+  if (required == 0) {
+    _regs[TCS34725_STATUS] |= TCS34725_STATUS_AINT;
+  } else if (counts[0] < low || counts[0] > high) {
+    if (_persistCount < 255)
+      _persistCount++;
+    if (_persistCount >= required)
+      _regs[TCS34725_STATUS] |= TCS34725_STATUS_AINT;
+  } else {
+    _persistCount = 0;
+  }
+
+  _cycleEnd += waitTime() + integrationTime();
+}
+
+/*!
+ *  @brief  Gets the length of one integration at the current ATIME
+ *  @return Microseconds
+ */
+uint32_t Adafruit_TCS34725_Sim::integrationTime() {
+  return (256 - _regs[TCS34725_ATIME]) * 2400UL;
+}
+
+/*!
+ *  @brief  Gets the wait between integrations, if the wait timer is enabled
+ *  @return Microseconds
+ */
+uint32_t Adafruit_TCS34725_Sim::waitTime() {
+  if (!(_regs[TCS34725_ENABLE] & TCS34725_ENABLE_WEN))
+    return 0;
+  uint32_t wait = (256 - _regs[TCS34725_WTIME]) * 2400UL;
+  if (_regs[TCS34725_CONFIG] & TCS34725_CONFIG_WLONG)
+    wait *= 12;
+  return wait;
+}
+
+/*!
+ *  @brief  Advances virtual time for bytes sent over the bus
+ *  @param  bytes
+ *          Bytes transferred
+ */
+void Adafruit_TCS34725_Sim::spendBusTime(size_t bytes) {
+  if (_busTime)
+    advance(_busTime * bytes);
+}
+
+/*!
+ *  @brief  Constructor. All channels start disconnected.
+ *  @param  *next
+ *          Another multiplexer on the same upstream bus, or NULL
+ */
+Adafruit_TCS34725_SimMux::Adafruit_TCS34725_SimMux(
+    Adafruit_TCS34725_SimMux *next)
+    : _next(next), _downstream(this), _mask(0), _selects(0) {
+  memset(_sensors, 0, sizeof(_sensors));
+}
+
+/*!
+ *  @brief  Checks that the simulated multiplexer is present
+ *  @return Always true
+ */
+bool Adafruit_TCS34725_SimMux::begin() { return true; }
+
+/*!
+ *  @brief  Sets the channel mask from the last byte written
+ *  @param  *buffer
+ *          Bytes written
+ *  @param  len
+ *          Number of bytes
+ *  @return False if nothing was written
+ */
+bool Adafruit_TCS34725_SimMux::write(const uint8_t *buffer, size_t len) {
+  if (len == 0)
+    return false;
+  _mask = buffer[len - 1];
+  _selects++;
+  return true;
+}
+
+/*!
+ *  @brief  Writes the channel mask and reads it back
+ *  @param  *write_buffer
+ *          Bytes to write
+ *  @param  write_len
+ *          Number of bytes to write
+ *  @param  *read_buffer
+ *          Destination for the bytes read
+ *  @param  read_len
+ *          Number of bytes to read
+ *  @return True on success
+ */
+bool Adafruit_TCS34725_SimMux::write_then_read(const uint8_t *write_buffer,
+                                               size_t write_len,
+                                               uint8_t *read_buffer,
+                                               size_t read_len) {
+  if (write_len && !write(write_buffer, write_len))
+    return false;
+  memset(read_buffer, _mask, read_len);
+  return true;
+}
+
+/*!
+ *  @brief  Connects a simulated sensor to a channel
+ *  @param  channel
+ *          Channel, 0-7
+ *  @param  *sensor
+ *          Sensor, or NULL to leave the channel empty
+ */
+void Adafruit_TCS34725_SimMux::attach(uint8_t channel,
+                                      Adafruit_TCS34725_Sim *sensor) {
+  if (channel < 8)
+    _sensors[channel] = sensor;
+}
+
+/*!
+ *  @brief  Gets the sensor-side bus, to use as the sensor transport of an
+ *          Adafruit_TCS34725_MuxChannel
+ *  @return Downstream transport
+ */
+Adafruit_TCS34725_Transport *Adafruit_TCS34725_SimMux::downstream() {
+  return &_downstream;
+}
+
+/*!
+ *  @brief  Gets the current channel mask
+ *  @return Mask, one bit per connected channel
+ */
+uint8_t Adafruit_TCS34725_SimMux::getMask() { return _mask; }
+
+/*!
+ *  @brief  Gets the number of channel mask writes
+ *  @return Select count
+ */
+uint32_t Adafruit_TCS34725_SimMux::getSelectCount() { return _selects; }
+
+/*!
+ *  @brief  Finds the one sensor connected across this multiplexer and the
+ *          ones chained to it
+ *  @return The sensor, or NULL if none or more than one is connected
+ */
+Adafruit_TCS34725_Sim *Adafruit_TCS34725_SimMux::route() {
+  Adafruit_TCS34725_Sim *found = NULL;
+  for (Adafruit_TCS34725_SimMux *m = this; m; m = m->_next) {
+    for (uint8_t i = 0; i < 8; i++) {
+      if ((m->_mask & (1 << i)) && m->_sensors[i]) {
+        if (found)
+          return NULL;
+        found = m->_sensors[i];
+      }
+    }
+  }
+  return found;
+}
+
+/*!
+ *  @brief  Checks that exactly one sensor is connected and responds
+ *  @return True if a sensor answers
+ */
+bool Adafruit_TCS34725_SimMux::Downstream::begin() {
+  Adafruit_TCS34725_Sim *sensor = _mux->route();
+  return sensor && sensor->begin();
+}
+
+/*!
+ *  @brief  Forwards a write to the connected sensor
+ *  @param  *buffer
+ *          Bytes to write
+ *  @param  len
+ *          Number of bytes
+ *  @return False (NACK) unless exactly one sensor is connected
+ */
+bool Adafruit_TCS34725_SimMux::Downstream::write(const uint8_t *buffer,
+                                                 size_t len) {
+  Adafruit_TCS34725_Sim *sensor = _mux->route();
+  return sensor && sensor->write(buffer, len);
+}
+
+/*!
+ *  @brief  Forwards a combined write/read to the connected sensor
+ *  @param  *write_buffer
+ *          Bytes to write
+ *  @param  write_len
+ *          Number of bytes to write
+ *  @param  *read_buffer
+ *          Destination for the bytes read
+ *  @param  read_len
+ *          Number of bytes to read
+ *  @return False (NACK) unless exactly one sensor is connected
+ */
+bool Adafruit_TCS34725_SimMux::Downstream::write_then_read(
+    const uint8_t *write_buffer, size_t write_len, uint8_t *read_buffer,
+    size_t read_len) {
+  Adafruit_TCS34725_Sim *sensor = _mux->route();
+  return sensor &&
+         sensor->write_then_read(write_buffer, write_len, read_buffer,
+                                 read_len);
+}
@@ -0,0 +1,129 @@
+/*!
+ *  @file Adafruit_TCS34725_Sim.h
+ *
+ *  In-memory model of a TCS34725 for exercising the driver without
+ *  hardware in the host tests. It lives under test/ so it is not built
+ *  into sketches or the ESP-IDF component.
+ *
+ *  BSD license (see license.txt)
+ */
+#ifndef _TCS34725_SIM_H_
+#define _TCS34725_SIM_H_
+
+#include "Adafruit_TCS34725.h"
+
+/*!
+ *  @brief  Simulated TCS34725 behind the driver's transport interface.
+ *
+ *          Models the register file, the command byte (repeated byte,
+ *          auto-increment and the 0x66 interrupt-clear special function),
+ *          the RGBC/wait state machine with AVALID and AINT/persistence,
+ *          analog/digital saturation and optional mains ripple on the
+ *          light. Time only moves when advance() is called or, if
+ *          setBusTime() is used, as bytes cross the bus, so a test can
+ *          drive it from a virtual clock.
+ */
+class Adafruit_TCS34725_Sim : public Adafruit_TCS34725_Transport {
+public:
+  Adafruit_TCS34725_Sim();
+
+  bool begin();
+  bool write(const uint8_t *buffer, size_t len);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len);
+
+  void advance(uint32_t us);
+  uint32_t getMicros();
+  uint32_t getMillis();
+
+  void setLight(float r, float g, float b, float c);
+  void setRipple(float hz, float depth);
+  void setGainFactors(const float gains[4]);
+  void setBusTime(uint16_t usPerByte);
+  void setPresent(bool present);
+  bool interruptAsserted();
+  uint8_t peek(uint8_t reg);
+
+  uint32_t getTransactionCount();
+  uint32_t getByteCount();
+  uint32_t getCycleCount();
+
+private:
+  void command(uint8_t cmd);
+  void writeRegister(uint8_t reg, uint8_t value);
+  void completeCycle();
+  uint32_t integrationTime();
+  uint32_t waitTime();
+  void spendBusTime(size_t bytes);
+
+  uint8_t _regs[TCS34725_BDATAH + 1]; ///< Register file
+  uint8_t _ptr;            ///< Register address pointer
+  bool _autoInc;           ///< Command type was auto-increment
+  bool _present;           ///< Whether the device acknowledges
+  bool _running;           ///< PON and AEN both set
+  uint32_t _now;           ///< Virtual time, microseconds
+  uint32_t _cycleEnd;      ///< Time the current integration completes
+  uint8_t _persistCount;   ///< Consecutive out-of-threshold cycles
+  float _light[4];         ///< Counts per 2.4ms at 1x gain, C/R/G/B order
+  float _gain[4];          ///< Actual multiplier for each AGAIN setting
+  uint16_t _busTime;       ///< Virtual time per byte transferred, us
+  uint32_t _transactions;  ///< Bus transactions seen
+  uint32_t _bytes;         ///< Bytes transferred, including command bytes
+  uint32_t _cycles;        ///< Integration cycles completed
+  float _rippleHz;         ///< Light ripple frequency, 0 for none
+  float _rippleDepth;      ///< Ripple amplitude as a fraction of _light
+};
+
+/*!
+ *  @brief  Simulated TCA9548A-style multiplexer. Writing a byte sets the
+ *          channel mask; downstream() is the bus the sensors sit on, which
+ *          routes each transaction to the simulated sensor on the one
+ *          connected channel across this multiplexer and any chained to it.
+ *          Transactions are NACKed when no sensor, or more than one sensor
+ *          (an address conflict), is connected.
+ */
+class Adafruit_TCS34725_SimMux : public Adafruit_TCS34725_Transport {
+public:
+  Adafruit_TCS34725_SimMux(Adafruit_TCS34725_SimMux *next = NULL);
+
+  bool begin();
+  bool write(const uint8_t *buffer, size_t len);
+  bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                       uint8_t *read_buffer, size_t read_len);
+
+  void attach(uint8_t channel, Adafruit_TCS34725_Sim *sensor);
+  Adafruit_TCS34725_Transport *downstream();
+  uint8_t getMask();
+  uint32_t getSelectCount();
+
+private:
+  Adafruit_TCS34725_Sim *route();
+
+  /*!
+   *  @brief  Sensor-side bus of a simulated multiplexer
+   */
+  class Downstream : public Adafruit_TCS34725_Transport {
+  public:
+    /*!
+     *  @brief  Constructor
+     *  @param  *mux
+     *          Multiplexer that owns this bus
+     */
+    Downstream(Adafruit_TCS34725_SimMux *mux) : _mux(mux) {}
+    bool begin();
+    bool write(const uint8_t *buffer, size_t len);
+    bool write_then_read(const uint8_t *write_buffer, size_t write_len,
+                         uint8_t *read_buffer, size_t read_len);
+
+  private:
+    Adafruit_TCS34725_SimMux *_mux; ///< Owning multiplexer
+  };
+
+  Adafruit_TCS34725_Sim *_sensors[8]; ///< Sensor on each channel, or NULL
+  Adafruit_TCS34725_SimMux *_next;    ///< Next multiplexer on the same bus
+  Downstream _downstream;             ///< Sensor-side bus
+  uint8_t _mask;                      ///< Connected channels
+  uint32_t _selects;                  ///< Channel mask writes seen
+};
+
+#endif
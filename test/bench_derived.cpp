@@ -0,0 +1,126 @@
+/*!
+ *  @file bench_derived.cpp
+ *
+ *  Per-sample cost of the DN40 colour temperature, lux and count-rate
+ *  conversion, before and after the configuration-dependent constants were
+ *  cached. "Before" works them out from ATIME and gain on every sample, as
+ *  the driver and the autorange example used to. The timings are printed
+ *  for information; only the results are checked. Both paths are kept out
+ *  of line, so the compiler cannot hoist the "before" arithmetic out of
+ *  the loop.
+ *
+ *  BSD license (see license.txt)
+ */
+#include <chrono>
+
+#include "test.h"
+
+/*!
+ *  @brief  Gives the benchmark access to the DN40 helpers
+ */
+class BenchTCS34725 : public Adafruit_TCS34725 {
+public:
+  /*!
+   *  @brief  Constructor
+   *  @param  it
+   *          Integration time
+   *  @param  gain
+   *          Gain
+   */
+  BenchTCS34725(uint8_t it, tcs34725Gain_t gain)
+      : Adafruit_TCS34725(it, gain) {}
+
+  /*!
+   *  @brief  The conversion with every constant recalculated per sample
+   *  @param  *s
+   *          Sample to convert
+   *  @param  *rate
+   *          Destination for the count rates
+   *  @return Colour temperature plus lux, to compare with after()
+   */
+  __attribute__((noinline)) uint32_t before(const tcs34725Sample_t *s,
+                                            tcs34725Rate_t *rate) {
+    static const uint8_t factor[4] = {1, 4, 16, 60};
+    uint32_t cycles = 256 - s->atime;
+    uint32_t gain = factor[s->gain & 0x03];
+
+    uint16_t sat = (cycles > 63) ? 65535 : 1024 * cycles;
+    if (cycles <= 63)
+      sat -= sat / 4;
+    uint32_t scale = (uint32_t)((5ULL << 42) / (12UL * cycles * gain * 1024));
+
+    rate->c = ((uint64_t)s->c * scale) >> 16;
+    rate->r = ((uint64_t)s->r * scale) >> 16;
+    rate->g = ((uint64_t)s->g * scale) >> 16;
+    rate->b = ((uint64_t)s->b * scale) >> 16;
+    return dn40ColorTemperature(s->r, s->g, s->b, s->c, sat) +
+           dn40Lux(s->r, s->g, s->b, s->c, 384UL * cycles * gain);
+  }
+
+  /*!
+   *  @brief  The conversion using the constants cached per configuration
+   *  @param  *s
+   *          Sample to convert
+   *  @param  *rate
+   *          Destination for the count rates
+   *  @return Colour temperature plus lux, to compare with before()
+   */
+  __attribute__((noinline)) uint32_t after(const tcs34725Sample_t *s,
+                                           tcs34725Rate_t *rate) {
+    normalizeSample(s, rate);
+    return calculateColorTemperature_dn40(s->r, s->g, s->b, s->c) +
+           calculateLux_dn40(s->r, s->g, s->b, s->c);
+  }
+};
+
+/*!
+ *  @brief  Runs the benchmark
+ *  @return Zero if both paths gave the same results
+ */
+int main() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  BenchTCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+  tcs.begin(&sim);
+  sim.setLight(300, 500, 400, 1300);
+  hostClockAdvance(24000);
+  tcs34725Sample_t base;
+  CHECK(tcs.getSample(&base));
+
+  const uint32_t count = 1000000;
+  tcs34725Sample_t sample = base;
+  tcs34725Rate_t rate, rate2;
+  volatile uint32_t sink = 0;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < count; i++) {
+    sample.c = base.c + (i & 0xFF);
+    sink = sink + tcs.before(&sample, &rate);
+  }
+  std::chrono::steady_clock::time_point middle =
+      std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < count; i++) {
+    sample.c = base.c + (i & 0xFF);
+    sink = sink + tcs.after(&sample, &rate);
+  }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  double beforeNs =
+      std::chrono::duration<double, std::nano>(middle - start).count() / count;
+  double afterNs =
+      std::chrono::duration<double, std::nano>(end - middle).count() / count;
+  printf("per sample: before %.1fns, after %.1fns\n", beforeNs, afterNs);
+
+  for (uint32_t i = 0; i < 256; i++) {
+    sample.c = base.c + i;
+    CHECK_EQ(tcs.before(&sample, &rate), tcs.after(&sample, &rate2));
+    CHECK_EQ(rate.c, rate2.c);
+    CHECK_EQ(rate.r, rate2.r);
+    CHECK_EQ(rate.g, rate2.g);
+    CHECK_EQ(rate.b, rate2.b);
+  }
+  return TEST_RESULT();
+}
@@ -0,0 +1,322 @@
+/*!
+ *  @file bench_fixed.cpp
+ *
+ *  Per-call cost of the float and integer-only colour temperature and lux
+ *  calculations on the host. Each kernel is timed over the same inputs and
+ *  reported in nanoseconds, in CPU cycles where a cycle counter is
+ *  available (the time stamp counter on x86), and in instructions executed
+ *  where the kernel's perf interface allows it. The float kernels are the
+ *  ones the integer versions replace: McCamy through pow() as the driver
+ *  used to do it, the current Horner form, and the DN40 lux and colour
+ *  temperature from the tcs34725autorange example. The figures are printed
+ *  for information; only the results are checked. On-target timings come
+ *  from the fixedpoint_benchmark example.
+ *
+ *  BSD license (see license.txt)
+ */
+#include <chrono>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "test.h"
+
+/** Sensor whose gain and integration time the kernels use */
+static Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_154MS, TCS34725_GAIN_4X);
+
+/** DN40 counts per lux at 153.6ms and 4x */
+static const float cpl = 2.4F * 64 * 4 / 310.0F;
+
+/** Kernel under test; returns its result so the call cannot be dropped */
+typedef uint32_t (*kernel_t)(uint16_t r, uint16_t g, uint16_t b, uint16_t c);
+
+/*!
+ *  @brief  McCamy through pow(), as calculateColorTemperature() used to be
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Unused
+ *  @return Color temperature in degrees Kelvin
+ */
+__attribute__((noinline)) static uint32_t mccamyPow(uint16_t r, uint16_t g,
+                                                    uint16_t b, uint16_t c) {
+  (void)c;
+  float X = (-0.14282F * r) + (1.54924F * g) + (-0.95641F * b);
+  float Y = (-0.32466F * r) + (1.57837F * g) + (-0.73191F * b);
+  float Z = (-0.68202F * r) + (0.77073F * g) + (0.56332F * b);
+  float xc = (X) / (X + Y + Z);
+  float yc = (Y) / (X + Y + Z);
+  float n = (xc - 0.3320F) / (0.1858F - yc);
+  float cct = (449.0F * (float)pow((double)n, 3.0)) +
+              (3525.0F * (float)pow((double)n, 2.0)) + (6823.3F * n) +
+              5520.33F;
+  return (uint32_t)cct;
+}
+
+/*!
+ *  @brief  calculateColorTemperature(), float in Horner form
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Unused
+ *  @return Color temperature in degrees Kelvin
+ */
+__attribute__((noinline)) static uint32_t mccamyFloat(uint16_t r, uint16_t g,
+                                                      uint16_t b, uint16_t c) {
+  (void)c;
+  return tcs.calculateColorTemperature(r, g, b);
+}
+
+/*!
+ *  @brief  calculateColorTemperature_fixed()
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Unused
+ *  @return Color temperature in degrees Kelvin
+ */
+__attribute__((noinline)) static uint32_t mccamyFixed(uint16_t r, uint16_t g,
+                                                      uint16_t b, uint16_t c) {
+  (void)c;
+  return tcs.calculateColorTemperature_fixed(r, g, b);
+}
+
+/*!
+ *  @brief  DN40 lux in float, as in the tcs34725autorange example
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Clear channel value
+ *  @return Lux value
+ */
+__attribute__((noinline)) static uint32_t luxFloat(uint16_t r, uint16_t g,
+                                                   uint16_t b, uint16_t c) {
+  float ir = (r + g + b > c) ? (r + g + b - c) / 2 : 0;
+  float lux = (0.136F * (r - ir) + 1.000F * (g - ir) - 0.444F * (b - ir)) / cpl;
+  return (lux > 0) ? (uint32_t)lux : 0;
+}
+
+/*!
+ *  @brief  calculateLux_dn40()
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Clear channel value
+ *  @return Lux value
+ */
+__attribute__((noinline)) static uint32_t luxFixed(uint16_t r, uint16_t g,
+                                                   uint16_t b, uint16_t c) {
+  return tcs.calculateLux_dn40(r, g, b, c);
+}
+
+/*!
+ *  @brief  DN40 colour temperature in float, as in the tcs34725autorange
+ *          example
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Clear channel value
+ *  @return Color temperature in degrees Kelvin
+ */
+__attribute__((noinline)) static uint32_t dn40Float(uint16_t r, uint16_t g,
+                                                    uint16_t b, uint16_t c) {
+  uint16_t ir = (r + g + b > c) ? (r + g + b - c) / 2 : 0;
+  float ct = 3810.0F * float(b - ir) / float(r - ir) + 1391.0F;
+  return (uint32_t)ct;
+}
+
+/*!
+ *  @brief  calculateColorTemperature_dn40()
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Clear channel value
+ *  @return Color temperature in degrees Kelvin
+ */
+__attribute__((noinline)) static uint32_t dn40Fixed(uint16_t r, uint16_t g,
+                                                    uint16_t b, uint16_t c) {
+  return tcs.calculateColorTemperature_dn40(r, g, b, c);
+}
+
+/*!
+ *  @brief  Counts instructions executed by this thread, if the kernel allows
+ */
+class InstructionCounter {
+public:
+  /*!
+   *  @brief  Opens the counter
+   */
+  InstructionCounter() : _fd(-1) {
+#if defined(__linux__)
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    _fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  /*!
+   *  @brief  Closes the counter
+   */
+  ~InstructionCounter() {
+#if defined(__linux__)
+    if (_fd >= 0)
+      close(_fd);
+#endif
+  }
+
+  /*!
+   *  @brief  Checks whether instructions can be counted
+   *  @return True if the counter opened
+   */
+  bool available() { return _fd >= 0; }
+
+  /*!
+   *  @brief  Zeroes and starts the counter
+   */
+  void start() {
+#if defined(__linux__)
+    if (_fd >= 0) {
+      ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  /*!
+   *  @brief  Stops the counter
+   *  @return Instructions since start(), or 0 if unavailable
+   */
+  uint64_t stop() {
+    uint64_t count = 0;
+#if defined(__linux__)
+    if (_fd >= 0) {
+      ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(_fd, &count, sizeof(count)) != sizeof(count))
+        count = 0;
+    }
+#endif
+    return count;
+  }
+
+private:
+  int _fd; ///< perf event descriptor, or -1
+};
+
+/*!
+ *  @brief  Reads the CPU cycle counter
+ *  @return Cycles, or 0 if there is no counter on this host
+ */
+static inline uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/** Calls per measurement */
+static const uint32_t count = 1000000;
+
+/*!
+ *  @brief  Times a kernel over a spread of inputs and prints the results
+ *  @param  name
+ *          Name to print
+ *  @param  fn
+ *          Kernel
+ *  @param  counter
+ *          Instruction counter
+ */
+static void measure(const char *name, kernel_t fn, InstructionCounter &counter) {
+  volatile uint32_t sink = 0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  uint64_t c0 = cycles();
+  counter.start();
+  for (uint32_t i = 0; i < count; i++)
+    sink = sink + fn(4200 + (i & 0x3FF), 3900, 2800 + (i >> 10 & 0x3FF), 10500);
+  uint64_t instructions = counter.stop();
+  uint64_t c1 = cycles();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration<double, std::nano>(end - start).count();
+  printf("%-24s %7.1fns", name, ns / count);
+  if (c1 != c0)
+    printf(" %7.1f cycles", (double)(c1 - c0) / count);
+  if (counter.available())
+    printf(" %7.1f instructions", (double)instructions / count);
+  printf("\n");
+}
+
+/*!
+ *  @brief  Runs the benchmark
+ *  @return Zero if each float and integer pair agreed
+ */
+int main() {
+  InstructionCounter counter;
+  if (!counter.available())
+    printf("instruction counts unavailable (perf_event_open refused)\n");
+
+  measure("McCamy, float + pow()", mccamyPow, counter);
+  measure("McCamy, float", mccamyFloat, counter);
+  measure("McCamy, fixed", mccamyFixed, counter);
+  measure("DN40 lux, float", luxFloat, counter);
+  measure("DN40 lux, fixed", luxFixed, counter);
+  measure("DN40 CCT, float", dn40Float, counter);
+  measure("DN40 CCT, fixed", dn40Fixed, counter);
+
+  /* The benchmark inputs are ordinary colours, where the float versions are
+     accurate, so each pair must agree to within their documented bounds */
+  for (uint32_t i = 0; i < 1024; i++) {
+    uint16_t r = 4200 + i, g = 3900, b = 2800 + i / 2, c = 10500;
+    int32_t d = mccamyFloat(r, g, b, c) - mccamyFixed(r, g, b, c);
+    CHECK(d >= -2 && d <= 2);
+    CHECK_EQ(mccamyPow(r, g, b, c), mccamyFloat(r, g, b, c));
+    d = luxFloat(r, g, b, c) - luxFixed(r, g, b, c);
+    CHECK(d >= -1 && d <= 1);
+    d = dn40Float(r, g, b, c) - dn40Fixed(r, g, b, c);
+    CHECK(d >= -1 && d <= 1);
+  }
+  return TEST_RESULT();
+}
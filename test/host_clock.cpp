@@ -0,0 +1,92 @@
+/*!
+ *  @file host_clock.cpp
+ *
+ *  Virtual clock for the host tests.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "host_clock.h"
+
+static Adafruit_TCS34725_Sim *clockSims[16]; ///< Sensors driven by the clock
+static uint8_t clockSimCount = 0;            ///< Entries in clockSims
+static uint32_t clockIdle = 0;    ///< Time while no sensor is attached, us
+static uint32_t clockDelayed = 0; ///< Time spent in delay(), ms
+
+/*!
+ *  @brief  Detaches all sensors and resets the time and delay total
+ */
+void hostClockReset() {
+  clockSimCount = 0;
+  clockIdle = 0;
+  clockDelayed = 0;
+}
+
+/*!
+ *  @brief  Attaches a simulated sensor. The first one attached keeps the
+ *          time, so bus time it is given with setBusTime() shows up in
+ *          micros(); the others only move when the clock is advanced.
+ *  @param  *sim
+ *          Sensor to drive
+ */
+void hostClockAttach(Adafruit_TCS34725_Sim *sim) {
+  if (clockSimCount < sizeof(clockSims) / sizeof(clockSims[0]))
+    clockSims[clockSimCount++] = sim;
+}
+
+/*!
+ *  @brief  Moves time forward for every attached sensor
+ *  @param  us
+ *          Microseconds to advance
+ */
+void hostClockAdvance(uint32_t us) {
+  clockIdle += us;
+  for (uint8_t i = 0; i < clockSimCount; i++)
+    clockSims[i]->advance(us);
+}
+
+/*!
+ *  @brief  Gets the time the driver has spent blocked in delay()
+ *  @return Milliseconds since hostClockReset()
+ */
+uint32_t hostClockDelayTotal() { return clockDelayed; }
+
+/*!
+ *  @brief  Virtual time
+ *  @return Milliseconds
+ */
+unsigned long millis(void) { return micros() / 1000; }
+
+/*!
+ *  @brief  Virtual time
+ *  @return Microseconds
+ */
+unsigned long micros(void) {
+  return clockSimCount ? clockSims[0]->getMicros() : clockIdle;
+}
+
+/*!
+ *  @brief  Advances virtual time
+ *  @param  ms
+ *          Milliseconds
+ */
+void delay(unsigned long ms) {
+  clockDelayed += ms;
+  hostClockAdvance(ms * 1000);
+}
+
+/*!
+ *  @brief  Advances virtual time
+ *  @param  us
+ *          Microseconds
+ */
+void delayMicroseconds(unsigned int us) { hostClockAdvance(us); }
+
+/*!
+ *  @brief  Does nothing; the tests have no interrupt handlers
+ */
+void noInterrupts(void) {}
+
+/*!
+ *  @brief  Does nothing; the tests have no interrupt handlers
+ */
+void interrupts(void) {}
@@ -0,0 +1,20 @@
+/*!
+ *  @file host_clock.h
+ *
+ *  Virtual clock for the host tests. It provides the driver's timing calls
+ *  (millis(), micros(), delay() and so on) and moves simulated sensors
+ *  forward with them, so tests run in simulated rather than real time.
+ *
+ *  BSD license (see license.txt)
+ */
+#ifndef _TCS34725_HOST_CLOCK_H_
+#define _TCS34725_HOST_CLOCK_H_
+
+#include "Adafruit_TCS34725_Sim.h"
+
+void hostClockReset();
+void hostClockAttach(Adafruit_TCS34725_Sim *sim);
+void hostClockAdvance(uint32_t us);
+uint32_t hostClockDelayTotal();
+
+#endif
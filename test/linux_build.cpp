@@ -0,0 +1,32 @@
+/*!
+ *  @file linux_build.cpp
+ *
+ *  Links the driver with the Linux i2c-dev transport and its real-time
+ *  clock, as a gateway would, and checks that a missing bus is reported.
+ *
+ *  BSD license (see license.txt)
+ */
+#include <stdio.h>
+
+#include "Adafruit_TCS34725_LinuxI2C.h"
+
+/*!
+ *  @brief  Runs the check
+ *  @return Zero on success
+ */
+int main() {
+  Adafruit_TCS34725_LinuxI2C bus("/dev/i2c-does-not-exist");
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+
+  unsigned long start = millis();
+  delay(2);
+  if (millis() - start < 2) {
+    printf("delay() returned early\n");
+    return 1;
+  }
+  if (tcs.begin(&bus)) {
+    printf("begin() succeeded without a bus\n");
+    return 1;
+  }
+  return 0;
+}
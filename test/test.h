@@ -0,0 +1,41 @@
+/*!
+ *  @file test.h
+ *
+ *  Minimal assertion helpers for the host tests. Each test is a program
+ *  that exits non-zero if any check failed.
+ *
+ *  BSD license (see license.txt)
+ */
+#ifndef _TCS34725_TEST_H_
+#define _TCS34725_TEST_H_
+
+#include <stdio.h>
+
+#include "host_clock.h"
+
+static int testFailures = 0; ///< Checks failed so far
+
+/** Records a failure, with its location, if cond is false */
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);          \
+      testFailures++;                                                          \
+    }                                                                          \
+  } while (0)
+
+/** Records a failure, with both values, if a != b */
+#define CHECK_EQ(a, b)                                                         \
+  do {                                                                         \
+    long long _a = (long long)(a), _b = (long long)(b);                        \
+    if (_a != _b) {                                                            \
+      printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__,       \
+             __LINE__, #a, #b, _a, _b);                                        \
+      testFailures++;                                                          \
+    }                                                                          \
+  } while (0)
+
+/** Exit status for main(): zero if every check passed */
+#define TEST_RESULT() (testFailures ? 1 : 0)
+
+#endif
@@ -0,0 +1,74 @@
+/*!
+ *  @file test_alloc.cpp
+ *
+ *  Checks that the driver never touches the heap: 10,000 begin/read cycles,
+ *  including copies of the driver object, must not call operator new.
+ *
+ *  BSD license (see license.txt)
+ */
+#include <new>
+#include <stdlib.h>
+
+#include "test.h"
+
+static unsigned long allocations = 0; ///< Calls to operator new so far
+
+/*!
+ *  @brief  Counting replacement for the global allocator
+ *  @param  size
+ *          Bytes to allocate
+ *  @return Allocated memory
+ */
+void *operator new(size_t size) {
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+/*!
+ *  @brief  Counting replacement for the global allocator
+ *  @param  size
+ *          Bytes to allocate
+ *  @return Allocated memory
+ */
+void *operator new[](size_t size) { return operator new(size); }
+
+/*!
+ *  @brief  Frees memory from operator new
+ *  @param  p
+ *          Memory to free
+ */
+void operator delete(void *p) noexcept { free(p); }
+
+/*!
+ *  @brief  Frees memory from operator new[]
+ *  @param  p
+ *          Memory to free
+ */
+void operator delete[](void *p) noexcept { free(p); }
+
+/*!
+ *  @brief  Runs the test
+ *  @return Zero if all checks passed
+ */
+int main() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  unsigned long before = allocations;
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_1X);
+  for (int i = 0; i < 10000; i++) {
+    CHECK(tcs.begin(&sim));
+    uint16_t r, g, b, c;
+    tcs.getRawData(&r, &g, &b, &c);
+
+    /* The autorange example's pattern: replace the object by assignment */
+    tcs = Adafruit_TCS34725(TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_4X);
+  }
+  CHECK_EQ(allocations - before, 0);
+  return TEST_RESULT();
+}
@@ -0,0 +1,165 @@
+/*!
+ *  @file test_autorange.cpp
+ *
+ *  Steps the simulated light across the sensor's range and checks that
+ *  Adafruit_TCS34725_Autorange lands in its 25-80% window with one range
+ *  change from an unsaturated reading, and with two from a saturated one,
+ *  which first falls back to the least sensitive setting.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "test.h"
+
+/** Nominal gain multiplier for each tcs34725Gain_t */
+static const uint8_t gainFactor[4] = {1, 4, 16, 60};
+
+/*!
+ *  @brief  Checks a clear count is inside the autoranger's target window
+ *  @param  counts
+ *          Clear channel counts
+ *  @param  ceiling
+ *          getSaturation75() at the setting they were read at
+ *  @return True if within 25-80% of ceiling
+ */
+static bool inWindow(float counts, uint16_t ceiling) {
+  uint16_t c = (counts >= ceiling) ? ceiling : (uint16_t)counts;
+  return c >= ceiling / 4 && c <= ceiling - ceiling / 5;
+}
+
+/*!
+ *  @brief  Polls until the autoranger returns an in-range reading
+ *  @param  *range
+ *          Autoranger
+ *  @param  *c
+ *          Clear channel value
+ *  @return True if a reading arrived within two seconds
+ */
+static bool readRanged(Adafruit_TCS34725_Autorange *range, uint16_t *c) {
+  uint16_t r, g, b;
+  for (uint32_t waited = 0; waited < 2000000; waited += 500) {
+    if (range->poll(&r, &g, &b, c))
+      return true;
+    hostClockAdvance(500);
+  }
+  return false;
+}
+
+/*!
+ *  @brief  Changes the light level and checks how many range changes the
+ *          autoranger needs, and where the clear channel ends up
+ *  @param  &sim
+ *          Simulated sensor
+ *  @param  &tcs
+ *          Driver
+ *  @param  *range
+ *          Autoranger
+ *  @param  light
+ *          Clear channel counts per 2.4ms at 1x
+ *  @return Range changes made
+ */
+static uint16_t step(Adafruit_TCS34725_Sim &sim, Adafruit_TCS34725 &tcs,
+                     Adafruit_TCS34725_Autorange *range, float light) {
+  /* One change if the current setting reads out of range. A saturated
+     reading falls back to 1x and one cycle, and needs a second change
+     unless that reads in range. */
+  uint16_t cycles = 256 - tcs.getIntegrationTime();
+  float counts = light * gainFactor[tcs.getGain()] * cycles;
+  uint16_t expected = inWindow(counts, tcs.getSaturation75()) ? 0 : 1;
+  if (counts >= tcs.getSaturation75() && !inWindow(light, 768))
+    expected = 2;
+
+  tcs34725AutorangeStats_t before, after;
+  range->getStats(&before);
+  sim.setLight(light / 4, light / 3, light / 4, light);
+  uint16_t c;
+  CHECK(readRanged(range, &c));
+  range->getStats(&after);
+
+  uint16_t changes = after.rangeChanges - before.rangeChanges;
+  if (changes != expected)
+    printf("light %.2f: %u changes, expected %u\n", light, changes, expected);
+  CHECK_EQ(changes, expected);
+  if (changes)
+    CHECK_EQ(after.lastSteps, changes);
+
+  CHECK(inWindow(c, tcs.getSaturation75()));
+  return changes;
+}
+
+/*!
+ *  @brief  Steps the light up and down across the range
+ */
+static void testStepResponse() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  Adafruit_TCS34725_Autorange range(&tcs);
+
+  /* Clear channel counts per 2.4ms at 1x, from near the 60x / 614ms floor
+     to near the 1x / 2.4ms ceiling */
+  static const float levels[] = {20, 2,   50,  1.5, 100, 3,  40,
+                                 8,  300, 1.2, 60,  450, 25, 2.5};
+  uint8_t once = 0, twice = 0;
+  for (uint8_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+    uint16_t changes = step(sim, tcs, &range, levels[i]);
+    if (changes == 1)
+      once++;
+    else if (changes == 2)
+      twice++;
+  }
+  /* The sequence must exercise both paths */
+  CHECK(once >= 3);
+  CHECK(twice >= 3);
+
+  tcs34725AutorangeStats_t stats;
+  range.getStats(&stats);
+  CHECK(stats.maxLatency > 0);
+  CHECK(stats.maxLatency < 2000);
+}
+
+/*!
+ *  @brief  Checks that darkness goes straight to maximum sensitivity and
+ *          that a saturating return to light recovers in two changes
+ */
+static void testDark() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(5, 5, 5, 15);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  Adafruit_TCS34725_Autorange range(&tcs);
+  uint16_t c;
+  CHECK(readRanged(&range, &c));
+
+  sim.setLight(0, 0, 0, 0);
+  tcs34725AutorangeStats_t before, after;
+  range.getStats(&before);
+  CHECK(readRanged(&range, &c));
+  range.getStats(&after);
+  CHECK_EQ(c, 0);
+  CHECK_EQ(after.rangeChanges - before.rangeChanges, 1);
+  CHECK_EQ(tcs.getGain(), TCS34725_GAIN_60X);
+  CHECK_EQ(tcs.getIntegrationTime(), TCS34725_INTEGRATIONTIME_614MS);
+
+  /* Still dark: nothing left to change */
+  CHECK(readRanged(&range, &c));
+  range.getStats(&before);
+  CHECK_EQ(before.rangeChanges, after.rangeChanges);
+
+  CHECK_EQ(step(sim, tcs, &range, 100), 2);
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  testStepResponse();
+  testDark();
+  return TEST_RESULT();
+}
@@ -0,0 +1,144 @@
+/*!
+ *  @file test_change.cpp
+ *
+ *  Runs report-on-change mode on the simulator: the interrupt window must
+ *  be centred on the reading, re-centred by every service(), and the
+ *  sensor must only interrupt when the light moves out of it for the
+ *  persistence count.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "test.h"
+
+/*!
+ *  @brief  Advances time in 100us steps, calling handleInterrupt() on each
+ *          assertion of the simulated INT pin, as an ISR attached FALLING
+ *          would be, and service() whenever one is pending
+ *  @param  sim
+ *          Simulated sensor
+ *  @param  tcs
+ *          Driver
+ *  @param  us
+ *          Microseconds to advance
+ *  @return Interrupts serviced
+ */
+static uint8_t run(Adafruit_TCS34725_Sim &sim, Adafruit_TCS34725 &tcs,
+                   uint32_t us) {
+  uint8_t serviced = 0;
+  bool asserted = sim.interruptAsserted();
+  for (uint32_t t = 0; t < us; t += 100) {
+    hostClockAdvance(100);
+    bool now = sim.interruptAsserted();
+    if (now && !asserted)
+      tcs.handleInterrupt();
+    if (tcs.service())
+      serviced++;
+    asserted = sim.interruptAsserted();
+  }
+  return serviced;
+}
+
+/*!
+ *  @brief  Gets the window programmed into the simulated sensor
+ *  @param  sim
+ *          Simulated sensor
+ *  @param  *low
+ *          Lower threshold
+ *  @param  *high
+ *          Upper threshold
+ */
+static void window(Adafruit_TCS34725_Sim &sim, uint16_t *low,
+                   uint16_t *high) {
+  *low = (uint16_t(sim.peek(TCS34725_AILTH)) << 8) | sim.peek(TCS34725_AILTL);
+  *high = (uint16_t(sim.peek(TCS34725_AIHTH)) << 8) | sim.peek(TCS34725_AIHTL);
+}
+
+/*!
+ *  @brief  Steps the light in and out of a 10% window
+ */
+static void testRecentre() {
+  tcs34725Sample_t buffer[8], sample;
+  Adafruit_TCS34725_SampleQueue queue(buffer, 8);
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  hostClockAdvance(30000);
+  tcs.beginChangeDetection(&queue, 10, TCS34725_PERS_2_CYCLE);
+
+  uint16_t low, high;
+  window(sim, &low, &high);
+  CHECK_EQ(low, 540);
+  CHECK_EQ(high, 660);
+  CHECK_EQ(sim.peek(TCS34725_PERS), TCS34725_PERS_2_CYCLE);
+
+  /* Steady light, and a 5% change, stay inside the window */
+  CHECK_EQ(run(sim, tcs, 10 * 24000), 0);
+  sim.setLight(10, 20, 30, 63);
+  CHECK_EQ(run(sim, tcs, 10 * 24000), 0);
+  CHECK_EQ(queue.available(), 0);
+
+  /* A 33% step interrupts once, after two cycles, and moves the window */
+  sim.setLight(10, 20, 30, 80);
+  CHECK_EQ(run(sim, tcs, 24000 + 12000), 0);
+  CHECK_EQ(run(sim, tcs, 24000), 1);
+  CHECK(queue.pop(&sample));
+  CHECK_EQ(sample.c, 800);
+  window(sim, &low, &high);
+  CHECK_EQ(low, 720);
+  CHECK_EQ(high, 880);
+  CHECK_EQ(run(sim, tcs, 10 * 24000), 0);
+
+  /* A single-cycle blip is filtered by the persistence */
+  sim.setLight(10, 20, 30, 20);
+  run(sim, tcs, 24000);
+  sim.setLight(10, 20, 30, 80);
+  CHECK_EQ(run(sim, tcs, 10 * 24000), 0);
+
+  /* Darkness: the window narrows to the minimum deadband around zero */
+  sim.setLight(0, 0, 0, 0);
+  CHECK_EQ(run(sim, tcs, 3 * 24000), 1);
+  CHECK(queue.pop(&sample));
+  CHECK_EQ(sample.c, 0);
+  window(sim, &low, &high);
+  CHECK_EQ(low, 0);
+  CHECK_EQ(high, 4);
+  CHECK_EQ(run(sim, tcs, 10 * 24000), 0);
+  CHECK_EQ(queue.available(), 0);
+}
+
+/*!
+ *  @brief  Starts change detection while no completed cycle is available;
+ *          the first real reading must be reported
+ */
+static void testFirstReading() {
+  tcs34725Sample_t buffer[4], sample;
+  Adafruit_TCS34725_SampleQueue queue(buffer, 4);
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  /* begin() waits out the first cycle; a gain change restarts it */
+  tcs.setGain(TCS34725_GAIN_4X);
+  tcs.beginChangeDetection(&queue, 10, TCS34725_PERS_1_CYCLE);
+  CHECK_EQ(run(sim, tcs, 30000), 1);
+  CHECK(queue.pop(&sample));
+  CHECK_EQ(sample.c, 2400);
+  CHECK_EQ(run(sim, tcs, 5 * 24000), 0);
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  testRecentre();
+  testFirstReading();
+  return TEST_RESULT();
+}
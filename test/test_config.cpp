@@ -0,0 +1,138 @@
+/*!
+ *  @file test_config.cpp
+ *
+ *  Checks applyConfig(): it writes only what changed, in at most six
+ *  transactions, and restarts the running cycle only when the timing
+ *  changes.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "test.h"
+
+/*!
+ *  @brief  Checks that the simulated registers hold a configuration
+ *  @param  &sim
+ *          Simulated sensor
+ *  @param  &config
+ *          Expected configuration
+ */
+static void checkRegisters(Adafruit_TCS34725_Sim &sim,
+                           const tcs34725Config_t &config) {
+  CHECK_EQ(sim.peek(TCS34725_ENABLE), config.enable);
+  CHECK_EQ(sim.peek(TCS34725_ATIME), config.atime);
+  CHECK_EQ(sim.peek(TCS34725_WTIME), config.wtime);
+  CHECK_EQ(sim.peek(TCS34725_CONFIG),
+           config.wlong ? TCS34725_CONFIG_WLONG : 0);
+  CHECK_EQ(sim.peek(TCS34725_PERS), config.pers);
+  CHECK_EQ(sim.peek(TCS34725_AILTL), config.lowThreshold & 0xFF);
+  CHECK_EQ(sim.peek(TCS34725_AILTH), config.lowThreshold >> 8);
+  CHECK_EQ(sim.peek(TCS34725_AIHTL), config.highThreshold & 0xFF);
+  CHECK_EQ(sim.peek(TCS34725_AIHTH), config.highThreshold >> 8);
+  CHECK_EQ(sim.peek(TCS34725_CONTROL), config.gain);
+}
+
+/*!
+ *  @brief  Counts the transactions of one applyConfig() call
+ */
+static void testTransactions() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  CHECK(tcs.begin(&sim));
+
+  /* Nothing changed */
+  tcs34725Config_t config;
+  tcs.getConfig(&config);
+  uint32_t tx = sim.getTransactionCount();
+  tcs.applyConfig(&config);
+  CHECK_EQ(sim.getTransactionCount() - tx, 0);
+
+  /* Everything changed while running: AEN off, WTIME-AIHTH, PERS-CONFIG,
+     CONTROL, ATIME and ENABLE */
+  config.enable = TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN |
+                  TCS34725_ENABLE_WEN | TCS34725_ENABLE_AIEN;
+  config.atime = TCS34725_INTEGRATIONTIME_50MS;
+  config.wtime = TCS34725_WTIME_204MS;
+  config.wlong = true;
+  config.pers = TCS34725_PERS_5_CYCLE;
+  config.lowThreshold = 0x0123;
+  config.highThreshold = 0x4567;
+  config.gain = TCS34725_GAIN_16X;
+  tx = sim.getTransactionCount();
+  tcs.applyConfig(&config);
+  CHECK_EQ(sim.getTransactionCount() - tx, 6);
+  checkRegisters(sim, config);
+
+  tcs34725Config_t check;
+  tcs.getConfig(&check);
+  CHECK_EQ(check.enable, config.enable);
+  CHECK_EQ(check.atime, config.atime);
+  CHECK_EQ(check.wtime, config.wtime);
+  CHECK_EQ(check.wlong, config.wlong);
+  CHECK_EQ(check.pers, config.pers);
+  CHECK_EQ(check.lowThreshold, config.lowThreshold);
+  CHECK_EQ(check.highThreshold, config.highThreshold);
+  CHECK_EQ(check.gain, config.gain);
+  CHECK_EQ(tcs.getIntegrationTime(), config.atime);
+  CHECK_EQ(tcs.getGain(), config.gain);
+
+  /* One end of each threshold: the two changed bytes are adjacent in
+     AILTH-AIHTL, so one auto-increment write */
+  config.lowThreshold = 0x2223;
+  config.highThreshold = 0x4511;
+  tx = sim.getTransactionCount();
+  tcs.applyConfig(&config);
+  CHECK_EQ(sim.getTransactionCount() - tx, 1);
+  checkRegisters(sim, config);
+}
+
+/*!
+ *  @brief  Checks that only timing changes restart the running cycle
+ */
+static void testRestart() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  CHECK(tcs.begin(&sim));
+  hostClockAdvance(30000);
+  CHECK(sim.peek(TCS34725_STATUS) & TCS34725_STATUS_AVALID);
+
+  /* Thresholds and persistence do not affect the cycle */
+  tcs34725Config_t config;
+  tcs.getConfig(&config);
+  config.lowThreshold = 100;
+  config.highThreshold = 1000;
+  config.pers = TCS34725_PERS_2_CYCLE;
+  uint32_t tx = sim.getTransactionCount();
+  tcs.applyConfig(&config);
+  CHECK_EQ(sim.getTransactionCount() - tx, 2);
+  CHECK(sim.peek(TCS34725_STATUS) & TCS34725_STATUS_AVALID);
+
+  /* A gain change abandons the cycle in progress: AEN off, CONTROL, AEN on,
+     and the next result is a full integration away */
+  config.gain = TCS34725_GAIN_4X;
+  tx = sim.getTransactionCount();
+  tcs.applyConfig(&config);
+  CHECK_EQ(sim.getTransactionCount() - tx, 3);
+  CHECK(!(sim.peek(TCS34725_STATUS) & TCS34725_STATUS_AVALID));
+  hostClockAdvance(24000 - 200);
+  CHECK(!(sim.peek(TCS34725_STATUS) & TCS34725_STATUS_AVALID));
+  hostClockAdvance(400);
+  CHECK(sim.peek(TCS34725_STATUS) & TCS34725_STATUS_AVALID);
+  CHECK_EQ(tcs.read16(TCS34725_CDATAL), 4 * 600);
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  testTransactions();
+  testRestart();
+  return TEST_RESULT();
+}
@@ -0,0 +1,162 @@
+/*!
+ *  @file test_fixed.cpp
+ *
+ *  Sweeps the integer-only McCamy colour temperature and DN40 lux
+ *  calculations over their input range and checks them against the same
+ *  formulas evaluated in double precision, to the bounds given in their
+ *  documentation.
+ *
+ *  BSD license (see license.txt)
+ */
+#include <math.h>
+
+#include "test.h"
+
+/*!
+ *  @brief  McCamy's colour temperature in double precision, with n clamped
+ *          to +/-1 as calculateColorTemperature_fixed() documents
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @return Color temperature in degrees Kelvin, truncated as the driver does
+ */
+static uint16_t mccamy(double r, double g, double b) {
+  double X = -0.14282 * r + 1.54924 * g - 0.95641 * b;
+  double Y = -0.32466 * r + 1.57837 * g - 0.73191 * b;
+  double Z = -0.68202 * r + 0.77073 * g + 0.56332 * b;
+  double S = X + Y + Z;
+  double num = X - 0.3320 * S, den = 0.1858 * S - Y;
+  double n = (fabs(num) >= fabs(den)) ? ((num < 0) != (den < 0) ? -1 : 1)
+                                      : num / den;
+  return (uint16_t)(((449 * n + 3525) * n + 6823.3) * n + 5520.33);
+}
+
+/*!
+ *  @brief  DN40 lux in double precision, as in the tcs34725autorange example
+ *          but with signed IR-compensated values
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @param  c
+ *          Clear channel value
+ *  @param  cpl
+ *          Counts per lux
+ *  @return Lux value
+ */
+static double dn40(double r, double g, double b, double c, double cpl) {
+  double ir = (r + g + b > c) ? floor((r + g + b - c) / 2) : 0;
+  return (0.136 * (r - ir) + (g - ir) - 0.444 * (b - ir)) / cpl;
+}
+
+/*!
+ *  @brief  Checks calculateColorTemperature_fixed() is within 1K of the
+ *          double precision result on a grid covering the full input range,
+ *          a grid of small values and pseudo-random points
+ */
+static void testMcCamy() {
+  Adafruit_TCS34725 tcs;
+  uint32_t worst = 0;
+  uint32_t seed = 1;
+
+  for (uint32_t i = 0; i < 3 * 262144; i++) {
+    uint16_t r, g, b;
+    if (i < 262144) {
+      /* 64 steps per channel across 0-65535 */
+      r = (i & 63) * 1040;
+      g = ((i >> 6) & 63) * 1040;
+      b = (i >> 12) * 1040;
+    } else if (i < 2 * 262144) {
+      r = i & 63;
+      g = (i >> 6) & 63;
+      b = (i >> 12) & 63;
+    } else {
+      seed = seed * 1103515245 + 12345;
+      r = seed >> 16;
+      seed = seed * 1103515245 + 12345;
+      g = seed >> 16;
+      seed = seed * 1103515245 + 12345;
+      b = seed >> 16;
+    }
+    if (r == 0 && g == 0 && b == 0)
+      continue;
+
+    uint16_t fixed = tcs.calculateColorTemperature_fixed(r, g, b);
+    uint16_t ref = mccamy(r, g, b);
+    uint32_t err = (fixed > ref) ? fixed - ref : ref - fixed;
+    if (err > 1 && worst <= 1)
+      printf("McCamy %u,%u,%u: fixed %u, double %u\n", r, g, b, fixed, ref);
+    if (err > worst)
+      worst = err;
+  }
+  printf("McCamy: worst error %luK\n", (unsigned long)worst);
+  CHECK(worst <= 1);
+
+  /* A colour whose matrix terms nearly cancel: 2571.96K in double
+     precision, 2566K in float */
+  CHECK_EQ(tcs.calculateColorTemperature_fixed(49277, 25633, 31404), 2572);
+  /* n beyond +/-1 is clamped */
+  CHECK_EQ(tcs.calculateColorTemperature_fixed(1000, 0, 0), 16317);
+  CHECK_EQ(tcs.calculateColorTemperature_fixed(0, 0, 1000), 1773);
+  CHECK_EQ(tcs.calculateColorTemperature_fixed(0, 0, 0), 0);
+}
+
+/*!
+ *  @brief  Checks calculateLux_dn40() is within 1 lux plus 0.15 counts'
+ *          worth of lux of the double precision result, at several
+ *          integration times and gains
+ */
+static void testLux() {
+  static const uint8_t atimes[3] = {TCS34725_INTEGRATIONTIME_2_4MS,
+                                    TCS34725_INTEGRATIONTIME_154MS,
+                                    TCS34725_INTEGRATIONTIME_614MS};
+  static const uint8_t gains[4] = {1, 4, 16, 60};
+  uint32_t seed = 7;
+
+  for (uint8_t a = 0; a < 3; a++) {
+    for (uint8_t k = 0; k < 4; k++) {
+      Adafruit_TCS34725 tcs(atimes[a], (tcs34725Gain_t)k);
+      double cpl = 2.4 * (256 - atimes[a]) * gains[k] / 310;
+      double bound = 1 + 0.15 / cpl;
+      double worst = 0;
+
+      for (uint32_t i = 0; i < 200000; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint16_t c = seed >> 16;
+        seed = seed * 1103515245 + 12345;
+        uint16_t r = (uint32_t)c * (seed >> 22) / 1024;
+        seed = seed * 1103515245 + 12345;
+        uint16_t g = (uint32_t)c * (seed >> 22) / 1024;
+        seed = seed * 1103515245 + 12345;
+        uint16_t b = (uint32_t)c * (seed >> 22) / 1024;
+
+        double ref = dn40(r, g, b, c, cpl);
+        if (ref < 0)
+          ref = 0;
+        if (ref > 65535)
+          ref = 65535;
+        double err = fabs(tcs.calculateLux_dn40(r, g, b, c) - ref);
+        if (err > worst)
+          worst = err;
+      }
+      printf("lux, ATIME 0x%02X, %ux: worst error %.3f, bound %.3f\n",
+             atimes[a], gains[k], worst, bound);
+      CHECK(worst <= bound);
+    }
+  }
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  testMcCamy();
+  testLux();
+  return TEST_RESULT();
+}
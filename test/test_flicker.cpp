@@ -0,0 +1,135 @@
+/*!
+ *  @file test_flicker.cpp
+ *
+ *  Runs the flicker-rejection reads on the simulator: getRawDataFlickerFree()
+ *  must scale steady light to one integration of the window length and
+ *  leave the configuration as it found it, and detectMains() must find the
+ *  ripple frequency of a lamp and report nothing for steady light.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "test.h"
+
+/*!
+ *  @brief  Checks that a value is within one count of a reference
+ *  @param  value
+ *          Value read
+ *  @param  ref
+ *          Expected value
+ *  @return True if close enough
+ */
+static bool near(uint16_t value, float ref) {
+  return value + 1 >= ref && value <= ref + 1;
+}
+
+/*!
+ *  @brief  Reads steady light over both windows and checks the result and
+ *          the restored configuration
+ *  @param  mains
+ *          Mains frequency to average over
+ */
+static void testSteadyLight(tcs34725Mains_t mains) {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(12, 24, 18, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_101MS, TCS34725_GAIN_4X);
+  CHECK(tcs.begin(&sim));
+  tcs34725Config_t config;
+  tcs.getConfig(&config);
+  config.enable |= TCS34725_ENABLE_WEN;
+  config.wtime = TCS34725_WTIME_204MS;
+  config.pers = TCS34725_PERS_3_CYCLE;
+  tcs.applyConfig(&config);
+
+  uint16_t r, g, b, c;
+  CHECK(tcs.getRawDataFlickerFree(&r, &g, &b, &c, mains));
+
+  /* Counts for one 20ms or 16.67ms integration at 4x */
+  float cycles = (mains == TCS34725_MAINS_60HZ) ? 16667 / 2400.0F
+                                                : 20000 / 2400.0F;
+  CHECK(near(c, 60 * 4 * cycles));
+  CHECK(near(r, 12 * 4 * cycles));
+  CHECK(near(g, 24 * 4 * cycles));
+  CHECK(near(b, 18 * 4 * cycles));
+
+  CHECK_EQ(sim.peek(TCS34725_ENABLE), config.enable);
+  CHECK_EQ(sim.peek(TCS34725_ATIME), TCS34725_INTEGRATIONTIME_101MS);
+  CHECK_EQ(sim.peek(TCS34725_WTIME), TCS34725_WTIME_204MS);
+  CHECK_EQ(sim.peek(TCS34725_PERS), TCS34725_PERS_3_CYCLE);
+  CHECK_EQ(sim.peek(TCS34725_CONTROL), TCS34725_GAIN_4X);
+  CHECK_EQ(tcs.getIntegrationTime(), TCS34725_INTEGRATIONTIME_101MS);
+
+  /* Normal sampling resumes at the restored integration time */
+  uint32_t cycleCount = sim.getCycleCount();
+  hostClockAdvance(tcs.getSamplePeriod() + 3000);
+  CHECK_EQ(sim.getCycleCount() - cycleCount, 1);
+  CHECK_EQ(tcs.read16(TCS34725_CDATAL), 60 * 4 * 42);
+}
+
+/*!
+ *  @brief  Runs mains detection under steady and rippled light
+ *  @param  rippleHz
+ *          Ripple frequency, or 0 for steady light
+ *  @param  depth
+ *          Ripple amplitude as a fraction of the mean
+ */
+static void testMains(float rippleHz, float depth) {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(40, 60, 30, 150);
+  sim.setRipple(rippleHz, depth);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  CHECK(tcs.begin(&sim));
+  tcs34725Mains_t mains = (tcs34725Mains_t)0xFF;
+  boolean found = tcs.detectMains(&mains);
+
+  /* The configuration is restored either way */
+  CHECK_EQ(sim.peek(TCS34725_ATIME), TCS34725_INTEGRATIONTIME_24MS);
+  CHECK_EQ(sim.peek(TCS34725_ENABLE),
+           TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN);
+  CHECK_EQ(sim.peek(TCS34725_PERS), TCS34725_PERS_NONE);
+
+  if (rippleHz == 0 || depth < 0.005F) {
+    CHECK(!found);
+    CHECK_EQ(mains, 0xFF);
+    CHECK(!tcs.setRippleFreeIntegrationTime());
+    CHECK_EQ(tcs.getIntegrationTime(), TCS34725_INTEGRATIONTIME_24MS);
+    return;
+  }
+
+  tcs34725Mains_t expected =
+      (rippleHz > 110) ? TCS34725_MAINS_60HZ : TCS34725_MAINS_50HZ;
+  CHECK(found);
+  CHECK_EQ(mains, expected);
+
+  /* Cached: no bus traffic the second time */
+  uint32_t tx = sim.getTransactionCount();
+  CHECK(tcs.detectMains(&mains));
+  CHECK_EQ(sim.getTransactionCount() - tx, 0);
+  CHECK_EQ(mains, expected);
+
+  CHECK(tcs.setRippleFreeIntegrationTime());
+  CHECK_EQ(tcs.getIntegrationTime(), expected == TCS34725_MAINS_60HZ
+                                         ? TCS34725_INTEGRATIONTIME_300MS
+                                         : TCS34725_INTEGRATIONTIME_60MS);
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  testSteadyLight(TCS34725_MAINS_50HZ);
+  testSteadyLight(TCS34725_MAINS_60HZ);
+  testMains(0, 0);
+  testMains(100, 0.002F);
+  testMains(100, 0.3F);
+  testMains(120, 0.3F);
+  testMains(100, 0.05F);
+  testMains(120, 0.05F);
+  return TEST_RESULT();
+}
@@ -0,0 +1,87 @@
+/*!
+ *  @file test_multi.cpp
+ *
+ *  Runs Adafruit_TCS34725_Multi over simulated sensors behind two chained
+ *  simulated multiplexers. The aggregate sample rate must be close to N
+ *  times that of one sensor, each result must come from the right sensor
+ *  and each should cost about one channel switch.
+ *
+ *  BSD license (see license.txt)
+ */
+#include <vector>
+
+#include "Adafruit_TCS34725_Multi.h"
+#include "test.h"
+
+/*!
+ *  @brief  Runs the given number of sensors for ten seconds of virtual time
+ *  @param  count
+ *          Number of sensors, 1-16
+ */
+static void checkThroughput(uint8_t count) {
+  hostClockReset();
+  Adafruit_TCS34725_SimMux muxB;
+  Adafruit_TCS34725_SimMux muxA(&muxB);
+  Adafruit_TCS34725_Transport *muxList[2] = {&muxA, &muxB};
+  Adafruit_TCS34725_Mux mux(muxList, 2);
+  CHECK(mux.begin());
+
+  Adafruit_TCS34725_Sim sims[16];
+  Adafruit_TCS34725 sensors[16];
+  Adafruit_TCS34725 *sensorList[16];
+  std::vector<Adafruit_TCS34725_MuxChannel> channels;
+  channels.reserve(count);
+  for (uint8_t i = 0; i < count; i++) {
+    hostClockAttach(&sims[i]);
+    /* A different level per sensor, to check where each result came from */
+    sims[i].setLight(i + 1, 2 * (i + 1), 3 * (i + 1), 6 * (i + 1));
+    (i < 8 ? muxA : muxB).attach(i % 8, &sims[i]);
+    channels.push_back(
+        Adafruit_TCS34725_MuxChannel(&mux, i, muxA.downstream()));
+
+    sensorList[i] = &sensors[i];
+    sensors[i] = Adafruit_TCS34725(TCS34725_INTEGRATIONTIME_24MS);
+    CHECK(sensors[i].begin(&channels[i]));
+  }
+
+  Adafruit_TCS34725_Multi multi(sensorList, count);
+  multi.start();
+  uint32_t switches = mux.getSwitchCount();
+  uint32_t perSensor[16] = {0};
+  uint32_t samples = 0;
+  for (uint32_t t = 0; t < 100000; t++) {
+    uint16_t r, g, b, c;
+    int8_t k = multi.poll(&r, &g, &b, &c);
+    if (k >= 0) {
+      samples++;
+      perSensor[k]++;
+      CHECK_EQ(c, 60 * (k + 1));
+      CHECK_EQ(r, 10 * (k + 1));
+    }
+    hostClockAdvance(100);
+  }
+  switches = mux.getSwitchCount() - switches;
+
+  /* One sensor at 24ms gives 416 results in 10s */
+  uint32_t single = 10000000UL / 24000;
+  printf("%u sensors: %lu samples (%.2fx one sensor), %lu switches\n", count,
+         (unsigned long)samples, (double)samples / single,
+         (unsigned long)switches);
+  CHECK(samples * 100 >= single * count * 97);
+  for (uint8_t i = 0; i < count; i++)
+    CHECK(perSensor[i] + 2 >= single);
+  /* One switch per result, plus a disconnect each time the round moves
+     between multiplexers */
+  CHECK(switches <= samples + samples / 8 + count);
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  checkThroughput(1);
+  checkThroughput(8);
+  checkThroughput(16);
+  return TEST_RESULT();
+}
@@ -0,0 +1,59 @@
+/*!
+ *  @file test_oneshot.cpp
+ *
+ *  Checks getRawDataOneShot(): it returns one complete integration, keeps
+ *  the sensor powered for about the integration time plus the 3ms
+ *  power-up, as reported by getAwakeTime(), and powers it down afterwards.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "test.h"
+
+/*!
+ *  @brief  Takes one-shot readings from a powered-down sensor
+ *  @param  it
+ *          Integration time
+ */
+static void testOneShot(uint8_t it) {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(it, TCS34725_GAIN_1X);
+  CHECK(tcs.begin(&sim));
+  tcs.disable();
+  CHECK_EQ(sim.peek(TCS34725_ENABLE) & TCS34725_ENABLE_PON, 0);
+
+  uint32_t cycles = 256 - it;
+  uint32_t integration = cycles * 2400;
+  for (uint8_t i = 0; i < 3; i++) {
+    hostClockAdvance(100000);
+    uint32_t before = sim.getCycleCount();
+    uint16_t r, g, b, c;
+    tcs.getRawDataOneShot(&r, &g, &b, &c);
+
+    CHECK_EQ(c, 60 * cycles);
+    CHECK_EQ(r, 10 * cycles);
+    CHECK_EQ(sim.getCycleCount() - before, 1);
+    CHECK_EQ(sim.peek(TCS34725_ENABLE) &
+                 (TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN),
+             0);
+
+    /* 3ms power-up, then the integration rounded up to the next ms */
+    uint32_t awake = tcs.getAwakeTime();
+    CHECK(awake >= integration + 3000);
+    CHECK(awake <= integration + 3000 + 1500);
+  }
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  testOneShot(TCS34725_INTEGRATIONTIME_2_4MS);
+  testOneShot(TCS34725_INTEGRATIONTIME_24MS);
+  testOneShot(TCS34725_INTEGRATIONTIME_154MS);
+  return TEST_RESULT();
+}
@@ -0,0 +1,118 @@
+/*!
+ *  @file test_poll.cpp
+ *
+ *  Runs poll() on the virtual clock: it must return one result per
+ *  integration cycle over long runs, never block, and stay off the bus
+ *  until a result is due.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "test.h"
+
+/*!
+ *  @brief  Polls every 100us for the given time
+ *  @param  it
+ *          Integration time
+ *  @param  periodMs
+ *          Sample period for setSamplePeriod(), or 0 to leave the wait
+ *          timer off
+ *  @param  runMs
+ *          Length of the run
+ */
+static void checkRate(uint8_t it, uint32_t periodMs, uint32_t runMs) {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(it, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  if (periodMs)
+    tcs.setSamplePeriod(periodMs);
+  uint32_t delayed = hostClockDelayTotal();
+
+  tcs.startMeasurement();
+  uint32_t cycles = sim.getCycleCount();
+  uint32_t tx = sim.getTransactionCount();
+  uint32_t samples = 0;
+  for (uint32_t t = 0; t < runMs * 10; t++) {
+    uint16_t r, g, b, c;
+    if (tcs.poll(&r, &g, &b, &c))
+      samples++;
+    hostClockAdvance(100);
+  }
+  cycles = sim.getCycleCount() - cycles;
+
+  printf("period %lu us: %lu samples, %lu cycles\n",
+         (unsigned long)tcs.getSamplePeriod(), (unsigned long)samples,
+         (unsigned long)cycles);
+  CHECK(samples + 1 >= cycles && samples <= cycles);
+  /* One read per result and no polling of STATUS before the deadline */
+  CHECK_EQ(sim.getTransactionCount() - tx, samples);
+  CHECK_EQ(hostClockDelayTotal() - delayed, 0);
+}
+
+/*!
+ *  @brief  Checks that a caller that polls less often than once per cycle
+ *          gets the latest result each time rather than a catch-up burst
+ */
+static void checkLateCaller() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  tcs.startMeasurement();
+  hostClockAdvance(30000);
+
+  uint32_t samples = 0;
+  for (int i = 0; i < 100; i++) {
+    uint16_t r, g, b, c;
+    if (tcs.poll(&r, &g, &b, &c))
+      samples++;
+    /* A second poll straight away has nothing new */
+    CHECK(!tcs.poll(&r, &g, &b, &c));
+    hostClockAdvance(50000);
+  }
+  CHECK_EQ(samples, 100);
+}
+
+/*!
+ *  @brief  Checks that setSamplePeriod() on a sensor that has not been
+ *          initialised yet keeps the integration time and gain given to the
+ *          constructor, and that long periods are limited to what the wait
+ *          timer can produce
+ */
+static void checkSamplePeriodSetup() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  /* A first begin() that fails leaves the sensor uninitialised */
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+  sim.setPresent(false);
+  CHECK(!tcs.begin(&sim));
+  sim.setPresent(true);
+
+  CHECK_EQ(tcs.setSamplePeriod(100), 100800);
+  CHECK_EQ(sim.peek(TCS34725_ATIME), TCS34725_INTEGRATIONTIME_24MS);
+  CHECK_EQ(sim.peek(TCS34725_CONTROL), TCS34725_GAIN_4X);
+
+  CHECK_EQ(tcs.setSamplePeriod(60000), 24000 + 256 * 28800UL);
+  CHECK_EQ(sim.peek(TCS34725_WTIME), 0);
+  CHECK(sim.peek(TCS34725_CONFIG) & TCS34725_CONFIG_WLONG);
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  checkRate(TCS34725_INTEGRATIONTIME_24MS, 0, 20000);
+  checkRate(TCS34725_INTEGRATIONTIME_2_4MS, 0, 20000);
+  checkRate(TCS34725_INTEGRATIONTIME_24MS, 100, 60000);
+  checkLateCaller();
+  checkSamplePeriodSetup();
+  return TEST_RESULT();
+}
@@ -0,0 +1,398 @@
+/*!
+ *  @file test_sample.cpp
+ *
+ *  Checks the tags getSample() puts on a sample: after a gain or
+ *  integration time change a sample is either marked invalid or was
+ *  integrated entirely at the setting it is tagged with, and the timestamp
+ *  is the end of the integration rather than the time of the read. Also
+ *  checks gain calibration and the configuration-dependent values the
+ *  driver caches.
+ *
+ *  BSD license (see license.txt)
+ */
+#include <math.h>
+
+#include "test.h"
+
+/*!
+ *  @brief  Checks that a normalized clear rate is within 2% of a reference
+ *  @param  rate
+ *          Normalized sample
+ *  @param  ref
+ *          Reference clear rate
+ *  @return True if close enough
+ */
+static bool sameRate(const tcs34725Rate_t &rate, uint32_t ref) {
+  uint32_t diff = rate.c > ref ? rate.c - ref : ref - rate.c;
+  return diff * 50 <= ref;
+}
+
+/*!
+ *  @brief  Switches range in the middle of a cycle and reads straight away,
+ *          then once the next cycle has completed
+ */
+static void testRangeSwitch() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  hostClockAdvance(24000);
+  tcs34725Sample_t sample;
+  tcs34725Rate_t rate;
+  CHECK(tcs.getSample(&sample));
+  tcs.normalizeSample(&sample, &rate);
+  uint32_t ref = rate.c;
+
+  for (int step = 0; step < 4; step++) {
+    hostClockAdvance(12000);
+    uint16_t generation = tcs.getConfigGeneration();
+    if (step & 1)
+      tcs.setIntegrationTime(step == 1 ? TCS34725_INTEGRATIONTIME_50MS
+                                       : TCS34725_INTEGRATIONTIME_24MS);
+    else
+      tcs.setGain(step == 0 ? TCS34725_GAIN_16X : TCS34725_GAIN_1X);
+    CHECK(tcs.getConfigGeneration() != generation);
+
+    /* Straight after the change: the old cycle's data must not be reported
+       as valid under the new tags */
+    if (tcs.getSample(&sample)) {
+      tcs.normalizeSample(&sample, &rate);
+      CHECK(sameRate(rate, ref));
+    }
+
+    /* Once a full cycle has run at the new setting */
+    hostClockAdvance(tcs.getSamplePeriod());
+    CHECK(tcs.getSample(&sample));
+    tcs.normalizeSample(&sample, &rate);
+    CHECK(sameRate(rate, ref));
+  }
+
+  /* Setting the same value again does not restart the cycle */
+  uint32_t tx = sim.getTransactionCount();
+  tcs.setGain(TCS34725_GAIN_1X);
+  tcs.setIntegrationTime(TCS34725_INTEGRATIONTIME_24MS);
+  CHECK_EQ(sim.getTransactionCount() - tx, 0);
+}
+
+/*!
+ *  @brief  Switches range while poll() is waiting; the next result must be
+ *          from the new setting and arrive one integration time later
+ */
+static void testRangeSwitchWhilePolling() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  tcs.startMeasurement();
+  hostClockAdvance(12000);
+  tcs.setGain(TCS34725_GAIN_4X);
+
+  uint16_t r, g, b, c;
+  uint32_t waited = 0;
+  while (!tcs.poll(&r, &g, &b, &c) && waited < 100000) {
+    hostClockAdvance(100);
+    waited += 100;
+  }
+  CHECK_EQ(c, 4 * 600);
+  CHECK(waited >= 24000 && waited <= 26000);
+}
+
+/*!
+ *  @brief  Reads samples part-way through later cycles and compares their
+ *          timestamps with the time the simulated cycle actually ended
+ *  @param  periodMs
+ *          Sample period for setSamplePeriod(), or 0 to leave the wait
+ *          timer off
+ */
+static void testTimestamp(uint32_t periodMs) {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  if (periodMs)
+    tcs.setSamplePeriod(periodMs);
+
+  for (int i = 0; i < 50; i++) {
+    /* Find the end of the next cycle to within 100us */
+    uint32_t cycles = sim.getCycleCount();
+    while (sim.getCycleCount() == cycles)
+      hostClockAdvance(100);
+    uint32_t end = sim.getMillis();
+
+    hostClockAdvance(1000 * (3 + i % 17));
+    tcs34725Sample_t sample;
+    CHECK(tcs.getSample(&sample));
+    CHECK(sample.timestamp + 1 >= end && sample.timestamp <= end + 1);
+  }
+}
+
+/*!
+ *  @brief  Checks that a 60x ratio above 64.0x, which a calibration may
+ *          measure within its 25% tolerance, is kept and used as given
+ */
+static void testWideGainRatio() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(1, 2, 3, 6);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_60X);
+  tcs.begin(&sim);
+  /* 60x measured as 72.0x */
+  const uint32_t ratios[4] = {1024, 4096, 16384, 73728};
+  tcs.setGainRatios(ratios);
+  uint32_t check[4];
+  tcs.getGainRatios(check);
+  CHECK_EQ(check[3], 73728);
+
+  hostClockAdvance(24000);
+  tcs34725Sample_t sample;
+  tcs34725Rate_t rate;
+  CHECK(tcs.getSample(&sample));
+  tcs.normalizeSample(&sample, &rate);
+  /* The simulator's 60x is exact, so the rate reads 60/72 of nominal:
+     60 counts / 24ms = 2.5 counts/ms */
+  CHECK(sameRate(rate, 163840UL * 60 / 72));
+}
+
+/*!
+ *  @brief  Checks dark capture into a zero-initialised table, and that a
+ *          pre-filled table is kept when asked
+ */
+static void testDarkTable() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(1, 1, 1, 2);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+
+  /* Zeroed, as a static or {} initialised array would be */
+  tcs34725Dark_t table[2] = {};
+  tcs.setDarkTable(table, 2);
+  CHECK(tcs.captureDark(2));
+  CHECK(tcs.captureDark(2));
+  CHECK_EQ(table[0].c, 20);
+  CHECK_EQ(table[1].gain, 0xFF);
+
+  sim.setLight(10, 20, 30, 60);
+  hostClockAdvance(48000);
+  tcs34725Sample_t sample;
+  CHECK(tcs.getSample(&sample));
+  CHECK_EQ(sample.c, 600 - 20);
+  CHECK_EQ(sample.r, 100 - 10);
+
+  /* A table restored from storage */
+  tcs34725Dark_t saved[1] = {
+      {TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X, 30, 5, 5, 5}};
+  tcs.setDarkTable(saved, 1, false);
+  CHECK(tcs.getSample(&sample));
+  CHECK_EQ(sample.c, 600 - 30);
+  CHECK_EQ(sample.r, 100 - 5);
+}
+
+/*!
+ *  @brief  Checks that a colour correction matrix is applied, and that one
+ *          with a shift outside 0-3 is refused
+ */
+static void testColorCorrection() {
+  Adafruit_TCS34725 tcs;
+  /* Swap R and B with 32767 (1.0 at shift 0), then halve with 8192 (0.5
+     at shift 1) and add 10 to B */
+  tcs34725Ccm_t swap = {{{0, 0, 32767}, {0, 32767, 0}, {32767, 0, 0}},
+                        {0, 0, 0},
+                        0};
+  tcs34725Ccm_t half = {{{8192, 0, 0}, {0, 8192, 0}, {0, 0, 8192}},
+                        {0, 0, 10},
+                        1};
+  tcs34725Sample_t sample = {};
+  sample.r = 1000;
+  sample.g = 2000;
+  sample.b = 3000;
+
+  CHECK(tcs.setColorCorrection(&swap));
+  tcs.correctColor(&sample);
+  CHECK_EQ(sample.r, 3000);
+  CHECK_EQ(sample.b, 1000);
+
+  CHECK(tcs.setColorCorrection(&half));
+  tcs.correctColor(&sample);
+  CHECK_EQ(sample.r, 1500);
+  CHECK_EQ(sample.g, 1000);
+  CHECK_EQ(sample.b, 510);
+
+  /* shift = 14 would shift by a negative amount */
+  half.shift = 14;
+  CHECK(!tcs.setColorCorrection(&half));
+  tcs.correctColor(&sample);
+  CHECK_EQ(sample.r, 1500);
+}
+
+/*!
+ *  @brief  Checks that gain ratios which would divide by zero or overflow
+ *          the count-rate scale are refused and the old ones kept
+ */
+static void testGainRatioLimits() {
+  Adafruit_TCS34725 tcs;
+  const uint32_t zero[4] = {0, 0, 0, 0};
+  const uint32_t low[4] = {511, 4096, 16384, 61440};
+  const uint32_t high[4] = {1024, 4096, 16384, 131073};
+  const uint32_t edge[4] = {512, 4096, 16384, 131072};
+  uint32_t check[4];
+
+  CHECK(!tcs.setGainRatios(zero));
+  CHECK(!tcs.setGainRatios(low));
+  CHECK(!tcs.setGainRatios(high));
+  tcs.getGainRatios(check);
+  CHECK_EQ(check[0], 1024);
+  CHECK_EQ(check[3], 61440);
+
+  CHECK(tcs.setGainRatios(edge));
+  tcs.getGainRatios(check);
+  CHECK_EQ(check[0], 512);
+  CHECK_EQ(check[3], 131072);
+}
+
+/*!
+ *  @brief  Checks that calibrateGains() recovers the simulator's off-nominal
+ *          gains and restores the configuration, and that a pair too bright
+ *          to measure keeps its previous ratio
+ */
+static void testCalibrateGains() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  const float gains[4] = {1.0F, 3.8F, 15.5F, 63.0F};
+  sim.setGainFactors(gains);
+  sim.setLight(1, 2, 2, 5);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+  tcs.begin(&sim);
+  CHECK(tcs.calibrateGains());
+
+  uint32_t ratios[4];
+  tcs.getGainRatios(ratios);
+  CHECK_EQ(ratios[0], 1024);
+  for (uint8_t i = 1; i < 4; i++) {
+    uint32_t ref = (uint32_t)(gains[i] * 1024);
+    uint32_t diff = ratios[i] > ref ? ratios[i] - ref : ref - ratios[i];
+    CHECK(diff * 500 <= ref);
+  }
+
+  CHECK_EQ(tcs.getIntegrationTime(), TCS34725_INTEGRATIONTIME_24MS);
+  CHECK_EQ(tcs.getGain(), TCS34725_GAIN_4X);
+  CHECK_EQ(sim.peek(TCS34725_ATIME), TCS34725_INTEGRATIONTIME_24MS);
+  CHECK_EQ(sim.peek(TCS34725_CONTROL), TCS34725_GAIN_4X);
+
+  /* A sample at the restored 4x now normalizes to the 1x rate:
+     5 counts / 2.4ms at 1x */
+  hostClockAdvance(tcs.getSamplePeriod());
+  tcs34725Sample_t sample;
+  tcs34725Rate_t rate;
+  CHECK(tcs.getSample(&sample));
+  tcs.normalizeSample(&sample, &rate);
+  CHECK(sameRate(rate, 5 * 65536 * 5 / 12));
+
+  /* Too bright for one cycle at 60x: that pair keeps its ratio */
+  const uint32_t nominal[4] = {1024, 4096, 16384, 61440};
+  CHECK(tcs.setGainRatios(nominal));
+  sim.setLight(4, 8, 8, 20);
+  CHECK(!tcs.calibrateGains());
+  tcs.getGainRatios(ratios);
+  CHECK(ratios[1] != 4096);
+  CHECK_EQ(ratios[3], 61440);
+}
+
+/*!
+ *  @brief  Checks that the generation only moves when the integration time
+ *          or gain does, and that a sample whose generation number matches
+ *          by wrap-around is still scaled by its own setting
+ */
+static void testGeneration() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  uint16_t generation = tcs.getConfigGeneration();
+
+  tcs34725Config_t config;
+  tcs.getConfig(&config);
+  config.lowThreshold = 100;
+  tcs.applyConfig(&config);
+  tcs.applyConfig(&config);
+  tcs.setGain(TCS34725_GAIN_1X);
+  const uint32_t ratios[4] = {1024, 4096, 16384, 61440};
+  tcs.setGainRatios(ratios);
+  CHECK_EQ(tcs.getConfigGeneration(), generation);
+
+  tcs.setGain(TCS34725_GAIN_4X);
+  CHECK_EQ(tcs.getConfigGeneration(), (uint16_t)(generation + 1));
+
+  /* A sample from 1x tagged with the current generation, as one 65536
+     changes old would be: the reference is 600 counts / 24ms at 1x */
+  tcs34725Sample_t sample = {};
+  sample.c = 600;
+  sample.atime = TCS34725_INTEGRATIONTIME_24MS;
+  sample.gain = TCS34725_GAIN_1X;
+  sample.generation = tcs.getConfigGeneration();
+  tcs34725Rate_t rate;
+  tcs.normalizeSample(&sample, &rate);
+  CHECK(sameRate(rate, 25UL * 65536));
+}
+
+/*!
+ *  @brief  Checks that the cached counts per lux and maximum lux follow
+ *          integration time, gain and gain ratio changes
+ */
+static void testCountsPerLux() {
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  float cpl = 2.4F * 10 / 310;
+  CHECK(fabsf(tcs.getCountsPerLux() - cpl) < cpl / 1000);
+  CHECK(fabsf(tcs.getMaxLux() - 65535 / (3 * cpl)) < 1);
+
+  tcs.setGain(TCS34725_GAIN_4X);
+  CHECK(fabsf(tcs.getCountsPerLux() - 4 * cpl) < cpl / 1000);
+  CHECK(fabsf(tcs.getMaxLux() - 65535 / (12 * cpl)) < 1);
+
+  /* 50MS is 21 cycles */
+  tcs.setIntegrationTime(TCS34725_INTEGRATIONTIME_50MS);
+  cpl = cpl * 21 / 10;
+  CHECK(fabsf(tcs.getCountsPerLux() - 4 * cpl) < cpl / 1000);
+
+  /* 4x measured as 5.0x */
+  const uint32_t ratios[4] = {1024, 5120, 16384, 61440};
+  tcs.setGainRatios(ratios);
+  CHECK(fabsf(tcs.getCountsPerLux() - 5 * cpl) < cpl / 1000);
+  CHECK(fabsf(tcs.getMaxLux() - 65535 / (15 * cpl)) < 1);
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  testRangeSwitch();
+  testRangeSwitchWhilePolling();
+  testTimestamp(0);
+  testTimestamp(100);
+  testWideGainRatio();
+  testGainRatioLimits();
+  testCalibrateGains();
+  testDarkTable();
+  testColorCorrection();
+  testCountsPerLux();
+  testGeneration();
+  return TEST_RESULT();
+}
@@ -0,0 +1,238 @@
+/*!
+ *  @file test_sim.cpp
+ *
+ *  Runs the driver against the simulated TCS34725: register access,
+ *  auto-increment, the 0x66 interrupt clear, interrupt-driven sampling,
+ *  AVALID timing and saturation.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "test.h"
+
+/*!
+ *  @brief  Checks that begin() finds the device and programs it
+ */
+static void testBegin() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+  CHECK(tcs.begin(&sim));
+  CHECK_EQ(sim.peek(TCS34725_ATIME), TCS34725_INTEGRATIONTIME_24MS);
+  CHECK_EQ(sim.peek(TCS34725_CONTROL), TCS34725_GAIN_4X);
+  CHECK_EQ(sim.peek(TCS34725_ENABLE),
+           TCS34725_ENABLE_PON | TCS34725_ENABLE_AEN);
+
+  Adafruit_TCS34725_Sim absent;
+  absent.setPresent(false);
+  Adafruit_TCS34725 missing;
+  CHECK(!missing.begin(&absent));
+}
+
+/*!
+ *  @brief  Checks auto-increment writes and reads
+ */
+static void testAutoIncrement() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725 tcs;
+  tcs.begin(&sim);
+  uint32_t tx = sim.getTransactionCount();
+  tcs.setIntLimits(0x1234, 0xABCD);
+  CHECK_EQ(sim.getTransactionCount() - tx, 1);
+  CHECK_EQ(sim.peek(TCS34725_AILTL), 0x34);
+  CHECK_EQ(sim.peek(TCS34725_AILTH), 0x12);
+  CHECK_EQ(sim.peek(TCS34725_AIHTL), 0xCD);
+  CHECK_EQ(sim.peek(TCS34725_AIHTH), 0xAB);
+
+  uint8_t buffer[4];
+  tcs.readBlock(TCS34725_AILTL, buffer, 4);
+  CHECK_EQ(buffer[0], 0x34);
+  CHECK_EQ(buffer[3], 0xAB);
+}
+
+/*!
+ *  @brief  Checks that AVALID is only set once an integration completes
+ */
+static void testAvalidTiming() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  tcs.startMeasurement();
+
+  tcs34725Snapshot_t snap;
+  CHECK(!tcs.getSnapshot(&snap));
+  hostClockAdvance(23000);
+  CHECK(!tcs.getSnapshot(&snap));
+  hostClockAdvance(1000);
+  CHECK(tcs.getSnapshot(&snap));
+  CHECK_EQ(snap.c, 600);
+  CHECK_EQ(snap.r, 100);
+  CHECK_EQ(snap.g, 200);
+  CHECK_EQ(snap.b, 300);
+}
+
+/*!
+ *  @brief  Checks analog saturation below 64 cycles and digital saturation
+ *          above
+ */
+static void testSaturation() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(5000, 5000, 5000, 5000);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_60X);
+  tcs.begin(&sim);
+  uint16_t r, g, b, c;
+  tcs.getRawData(&r, &g, &b, &c);
+  CHECK_EQ(c, 10240);
+  CHECK(c >= tcs.getSaturation75());
+
+  tcs.setIntegrationTime(TCS34725_INTEGRATIONTIME_614MS);
+  hostClockAdvance(700000);
+  tcs.getRawData(&r, &g, &b, &c);
+  CHECK_EQ(c, 65535);
+}
+
+/*!
+ *  @brief  Checks that the 0x66 special function clears AINT and releases
+ *          the INT pin
+ */
+static void testInterruptClear() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  tcs.beginInterrupts(NULL);
+  CHECK(!sim.interruptAsserted());
+  hostClockAdvance(2400);
+  CHECK(sim.interruptAsserted());
+  tcs.clearInterrupt();
+  CHECK(!sim.interruptAsserted());
+  CHECK(!(sim.peek(TCS34725_STATUS) & TCS34725_STATUS_AINT));
+}
+
+/*!
+ *  @brief  Advances time in 100us steps, calling handleInterrupt() on each
+ *          falling edge of the active-low INT pin, as an ISR attached with
+ *          FALLING would be
+ *  @param  sim
+ *          Simulated sensor
+ *  @param  tcs
+ *          Driver
+ *  @param  us
+ *          Microseconds to advance
+ *  @param  asserted
+ *          Pin state, carried between calls
+ */
+static void runIsr(Adafruit_TCS34725_Sim &sim, Adafruit_TCS34725 &tcs,
+                   uint32_t us, bool &asserted) {
+  for (uint32_t t = 0; t < us; t += 100) {
+    hostClockAdvance(100);
+    bool now = sim.interruptAsserted();
+    if (now && !asserted)
+      tcs.handleInterrupt();
+    asserted = now;
+  }
+}
+
+/*!
+ *  @brief  Checks the sample queue limits and the interrupt sampling path,
+ *          including results overwritten before service() ran
+ */
+static void testInterruptQueue() {
+  tcs34725Sample_t one[1], four[4], sample = {};
+  Adafruit_TCS34725_SampleQueue tiny(one, 1);
+  CHECK(!tiny.push(&sample));
+  CHECK(!tiny.pop(&sample));
+  CHECK_EQ(tiny.getOverruns(), 1);
+  CHECK_EQ(tiny.available(), 0);
+
+  Adafruit_TCS34725_SampleQueue queue(four, 4);
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  tcs.beginInterrupts(&queue);
+  bool asserted = false;
+  for (int i = 0; i < 5; i++) {
+    runIsr(sim, tcs, 24000, asserted);
+    CHECK(tcs.service());
+    asserted = sim.interruptAsserted();
+  }
+  /* Three slots: two samples were dropped, none were missed */
+  CHECK_EQ(queue.available(), 3);
+  CHECK_EQ(queue.getOverruns(), 2);
+  CHECK_EQ(tcs.getMissedInterrupts(), 0);
+  while (queue.pop(&sample))
+    CHECK_EQ(sample.c, 600);
+
+  /* Three cycles before service(): INT stays asserted, so the ISR runs
+     once, and the first two results are overwritten */
+  uint32_t cycles = sim.getCycleCount();
+  runIsr(sim, tcs, 3 * 24000 + 5000, asserted);
+  CHECK_EQ(sim.getCycleCount() - cycles, 3);
+  CHECK(tcs.service());
+  asserted = sim.interruptAsserted();
+  CHECK_EQ(tcs.getMissedInterrupts(), 2);
+  /* The sample is the last cycle's, about 5ms old */
+  CHECK(queue.pop(&sample));
+  CHECK(sample.timestamp + 6 >= sim.getMillis() &&
+        sample.timestamp + 4 <= sim.getMillis());
+
+  /* Serviced in time again: the next interrupt follows the clear */
+  runIsr(sim, tcs, 24000, asserted);
+  CHECK(tcs.service());
+  CHECK_EQ(tcs.getMissedInterrupts(), 2);
+  CHECK(!tcs.service());
+}
+
+/*!
+ *  @brief  Load test: the bus cost of sampling must stay at one
+ *          transaction and ten bytes per snapshot
+ */
+static void testLoad() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  uint32_t tx = sim.getTransactionCount(), bytes = sim.getByteCount();
+  for (int i = 0; i < 10000; i++) {
+    tcs34725Snapshot_t snap;
+    tcs.getSnapshot(&snap);
+    hostClockAdvance(2400);
+  }
+  CHECK_EQ(sim.getTransactionCount() - tx, 10000);
+  CHECK_EQ(sim.getByteCount() - bytes, 100000);
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  testBegin();
+  testAutoIncrement();
+  testAvalidTiming();
+  testSaturation();
+  testInterruptClear();
+  testInterruptQueue();
+  testLoad();
+  return TEST_RESULT();
+}
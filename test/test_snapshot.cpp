@@ -0,0 +1,77 @@
+/*!
+ *  @file test_snapshot.cpp
+ *
+ *  Checks that getSnapshot() returns all four channels from one integration
+ *  cycle, even when a cycle ends while the bus is busy, whereas separate
+ *  read16() calls can mix two cycles.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "test.h"
+
+/*!
+ *  @brief  Checks that a reading matches the 8:1:2:4 C:R:G:B ratio set by
+ *          setLight() below, i.e. that no channel came from another cycle
+ *  @param  c
+ *          Clear channel value
+ *  @param  r
+ *          Red value
+ *  @param  g
+ *          Green value
+ *  @param  b
+ *          Blue value
+ *  @return True if the channels are from the same cycle
+ */
+static bool coherent(uint16_t c, uint16_t r, uint16_t g, uint16_t b) {
+  return c == 8 * r && c == 4 * g && c == 2 * b;
+}
+
+/*!
+ *  @brief  Runs the test
+ *  @return Zero if all checks passed
+ */
+int main() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_2_4MS, TCS34725_GAIN_1X);
+  tcs.begin(&sim);
+  /* 100kHz bus: a burst read or four read16() calls take about 1ms, so
+     many reads straddle the end of a 2.4ms cycle */
+  sim.setBusTime(90);
+
+  int snapTorn = 0, legacyTorn = 0, straddled = 0;
+  for (uint32_t i = 0; i < 2000; i++) {
+    /* A different level for every cycle */
+    uint16_t k = 10 + (i % 13);
+    sim.setLight(k, 2 * k, 4 * k, 8 * k);
+    hostClockAdvance(37 * (i % 29));
+
+    uint32_t cycles = sim.getCycleCount();
+    tcs34725Snapshot_t snap;
+    CHECK(tcs.getSnapshot(&snap));
+    CHECK(snap.status & TCS34725_STATUS_AVALID);
+    if (sim.getCycleCount() != cycles)
+      straddled++;
+    if (!coherent(snap.c, snap.r, snap.g, snap.b))
+      snapTorn++;
+
+    /* The old getRawData(): one transaction per channel */
+    sim.setLight(k + 1, 2 * (k + 1), 4 * (k + 1), 8 * (k + 1));
+    uint16_t c = tcs.read16(TCS34725_CDATAL);
+    uint16_t r = tcs.read16(TCS34725_RDATAL);
+    uint16_t g = tcs.read16(TCS34725_GDATAL);
+    uint16_t b = tcs.read16(TCS34725_BDATAL);
+    if (!coherent(c, r, g, b))
+      legacyTorn++;
+  }
+
+  printf("cycle ended during %d snapshots; torn: snapshot %d, read16 %d\n",
+         straddled, snapTorn, legacyTorn);
+  CHECK(straddled > 0);
+  CHECK_EQ(snapTorn, 0);
+  /* Shows the test would catch a non-atomic read */
+  CHECK(legacyTorn > 0);
+  return TEST_RESULT();
+}
@@ -0,0 +1,69 @@
+/*!
+ *  @file test_static.cpp
+ *
+ *  Checks Adafruit_TCS34725_Static: it reads and converts like the runtime
+ *  driver, and cannot be handed to code that changes the integration time
+ *  or gain through an Adafruit_TCS34725 pointer.
+ *
+ *  BSD license (see license.txt)
+ */
+#include <type_traits>
+
+#include "Adafruit_TCS34725_Static.h"
+#include "test.h"
+
+typedef Adafruit_TCS34725_Static<TCS34725_INTEGRATIONTIME_24MS,
+                                 TCS34725_GAIN_4X>
+    StaticSensor; ///< Sensor type under test
+
+static_assert(!std::is_convertible<StaticSensor *, Adafruit_TCS34725 *>::value,
+              "a fixed-setting sensor must not convert to the base class");
+static_assert(StaticSensor::saturation75() == 7680, "10 cycles, analog");
+
+/** True if T has a callable setGainRatios() */
+template <typename T, typename = void>
+struct hasSetGainRatios : std::false_type {};
+/** Specialisation chosen when the call compiles */
+template <typename T>
+struct hasSetGainRatios<T, decltype((void)std::declval<T &>().setGainRatios(
+                               (const uint32_t *)0))> : std::true_type {};
+
+static_assert(hasSetGainRatios<Adafruit_TCS34725>::value, "check the trait");
+static_assert(!hasSetGainRatios<StaticSensor>::value,
+              "the constant DN40 path cannot honour measured gain ratios");
+
+/*!
+ *  @brief  Runs the test
+ *  @return Zero if all checks passed
+ */
+int main() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  StaticSensor tcs;
+  CHECK(tcs.begin(&sim));
+  CHECK_EQ(sim.peek(TCS34725_ATIME), TCS34725_INTEGRATIONTIME_24MS);
+  CHECK_EQ(sim.peek(TCS34725_CONTROL), TCS34725_GAIN_4X);
+
+  uint16_t r, g, b, c;
+  tcs.getRawData(&r, &g, &b, &c);
+  CHECK_EQ(c, 2400);
+  CHECK_EQ(r, 400);
+
+  Adafruit_TCS34725 runtime(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+  CHECK_EQ(StaticSensor::calculateLux_dn40(r, g, b, c),
+           runtime.calculateLux_dn40(r, g, b, c));
+  CHECK_EQ(StaticSensor::calculateColorTemperature_dn40(r, g, b, c),
+           runtime.calculateColorTemperature_dn40(r, g, b, c));
+
+  /* The re-exported API still works */
+  tcs34725Sample_t sample;
+  hostClockAdvance(24000);
+  CHECK(tcs.getSample(&sample));
+  CHECK_EQ(sample.gain, TCS34725_GAIN_4X);
+  CHECK_EQ(tcs.setSamplePeriod(100), 100800);
+  CHECK_EQ(tcs.getIntegrationTime(), TCS34725_INTEGRATIONTIME_24MS);
+  return TEST_RESULT();
+}
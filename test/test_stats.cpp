@@ -0,0 +1,140 @@
+/*!
+ *  @file test_stats.cpp
+ *
+ *  Checks the TCS34725_STATS instrumentation against the simulator's own
+ *  bus counters and the virtual clock: transactions, bytes, NACKs, time
+ *  spent in delay() and the latency histogram. Built with TCS34725_STATS
+ *  defined, against its own copy of the driver.
+ *
+ *  BSD license (see license.txt)
+ */
+#include "Adafruit_TCS34725_Static.h"
+#include "test.h"
+
+/*!
+ *  @brief  Adds up one operation's latency histogram
+ *  @param  &stats
+ *          Counters
+ *  @param  op
+ *          Operation
+ *  @return Operations recorded
+ */
+static uint32_t histogramTotal(const tcs34725Stats_t &stats, uint8_t op) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < TCS34725_STATS_BUCKETS; i++)
+    total += stats.latency[op][i];
+  return total;
+}
+
+/*!
+ *  @brief  Checks the counters after begin(), blocking reads and a
+ *          disconnected sensor
+ */
+static void testCounters() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+  sim.setLight(10, 20, 30, 60);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+  CHECK(tcs.begin(&sim));
+
+  tcs34725Stats_t stats;
+  tcs.getStats(&stats);
+  CHECK_EQ(stats.transactions, sim.getTransactionCount());
+  CHECK_EQ(stats.bytes, sim.getByteCount());
+  CHECK_EQ(stats.nacks, 0);
+  CHECK_EQ(stats.delayMs, hostClockDelayTotal());
+
+  /* Each getRawData() is one burst read of 1 + 8 bytes and a 25ms wait */
+  tcs.resetStats();
+  uint32_t tx = sim.getTransactionCount();
+  uint32_t bytes = sim.getByteCount();
+  uint32_t delayed = hostClockDelayTotal();
+  uint16_t r, g, b, c;
+  for (uint8_t i = 0; i < 4; i++)
+    tcs.getRawData(&r, &g, &b, &c);
+  tcs.getStats(&stats);
+  CHECK_EQ(stats.transactions, 4);
+  CHECK_EQ(stats.transactions, sim.getTransactionCount() - tx);
+  CHECK_EQ(stats.bytes, 4 * 9);
+  CHECK_EQ(stats.bytes, sim.getByteCount() - bytes);
+  CHECK_EQ(stats.delayMs, 4 * 25);
+  CHECK_EQ(stats.delayMs, hostClockDelayTotal() - delayed);
+  CHECK_EQ(histogramTotal(stats, TCS34725_OP_READ_BLOCK), 4);
+  CHECK_EQ(histogramTotal(stats, TCS34725_OP_WRITE8), 0);
+
+  /* Every transaction to an absent sensor is a NACK */
+  tcs.resetStats();
+  sim.setPresent(false);
+  tcs.read8(TCS34725_ID);
+  tcs.read16(TCS34725_CDATAL);
+  tcs.clearInterrupt();
+  tcs.getStats(&stats);
+  CHECK_EQ(stats.transactions, 3);
+  CHECK_EQ(stats.nacks, 3);
+  CHECK_EQ(histogramTotal(stats, TCS34725_OP_READ8), 1);
+  CHECK_EQ(histogramTotal(stats, TCS34725_OP_READ16), 1);
+  CHECK_EQ(histogramTotal(stats, TCS34725_OP_CLEAR_INT), 1);
+  sim.setPresent(true);
+}
+
+/*!
+ *  @brief  Checks that bus time lands in the right latency bucket
+ */
+static void testLatency() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725 tcs(TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X);
+  CHECK(tcs.begin(&sim));
+  tcs.resetStats();
+
+  /* 9 bytes at 23us (400kHz) is 207us: the 128-256us bucket. 2 bytes at
+     90us (100kHz) is 180us, the same bucket. */
+  sim.setBusTime(23);
+  tcs34725Snapshot_t snap;
+  tcs.getSnapshot(&snap);
+  sim.setBusTime(90);
+  tcs.read8(TCS34725_ID);
+  tcs34725Stats_t stats;
+  tcs.getStats(&stats);
+  CHECK_EQ(stats.latency[TCS34725_OP_READ_BLOCK][2], 1);
+  CHECK_EQ(stats.latency[TCS34725_OP_READ8][2], 1);
+}
+
+/*!
+ *  @brief  Checks that the fixed-setting driver's blocking read is counted
+ */
+static void testStatic() {
+  Adafruit_TCS34725_Sim sim;
+  hostClockReset();
+  hostClockAttach(&sim);
+
+  Adafruit_TCS34725_Static<TCS34725_INTEGRATIONTIME_24MS, TCS34725_GAIN_4X>
+      tcs;
+  CHECK(tcs.begin(&sim));
+  tcs.resetStats();
+  uint32_t delayed = hostClockDelayTotal();
+  uint16_t r, g, b, c;
+  tcs.getRawData(&r, &g, &b, &c);
+  tcs.getRawData(&r, &g, &b, &c);
+
+  tcs34725Stats_t stats;
+  tcs.getStats(&stats);
+  CHECK_EQ(stats.transactions, 2);
+  CHECK_EQ(stats.delayMs, 2 * 25);
+  CHECK_EQ(stats.delayMs, hostClockDelayTotal() - delayed);
+}
+
+/*!
+ *  @brief  Runs the tests
+ *  @return Zero if all checks passed
+ */
+int main() {
+  testCounters();
+  testLatency();
+  testStatic();
+  return TEST_RESULT();
+}